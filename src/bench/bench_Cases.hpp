@@ -0,0 +1,236 @@
+/*!
+ * \file       bench_Cases.hpp
+ * Copyright   Eiosis 2014
+ */
+
+#pragma once
+
+#include "bench/bench_Suite.h"
+#include "framework/framework_Cells.h"
+#include "framework/framework_Oversampling.h"
+#include "framework/framework_Plugin.h"
+#include "framework/framework_Reference.h"
+
+#include <cstdlib>
+#include <vector>
+
+namespace bench
+{
+    inline const char* getTypeName(dsp::float32)
+    {
+        return "float32";
+    }
+    inline const char* getTypeName(dsp::float64)
+    {
+        return "float64";
+    }
+
+    /*!
+        Same bell as RockyProcessor::internalMapBell.
+    */
+    inline dsp::IIR::Port makeBell(double inSamplerate, double inFrequency, double inQ, double inGain)
+    {
+        const double a      = std::pow(10., inGain / 40.);
+        const double w      = dsp::twoPi_64 * std::min(inFrequency, .5 * inSamplerate - 100.) / inSamplerate;
+        const double alpha  = .5 * std::sin(w) / inQ;
+        const double c2     = -2. * std::cos(w);
+        const double ib0    = 1. / (1. + alpha / a);
+
+        const dsp::IIR::Port port = { { ib0 * (1. + alpha * a), ib0 * c2, ib0 * (1. - alpha * a),
+                                        1., ib0 * c2, ib0 * (1. - alpha / a) } };
+        return port;
+    }
+
+    // -------------------------------------------------------------------------
+
+    /*!
+        Noise input and a separate output, for blocks of up to plugin::gNumMaxChannels channels.
+        Processing out of place keeps the input the same from block to block,
+        so that it never decays into silence (which the cells skip) nor grows out of range.
+    */
+    template<typename SampleType>
+    class Buffers
+    {
+    public:
+        void prepare(int inNumChannels, int inBlockSize)
+        {
+            mInput.resize(inNumChannels * inBlockSize);
+            mOutput.resize(inNumChannels * inBlockSize);
+            mInputChannels.resize(inNumChannels);
+            mOutputChannels.resize(inNumChannels);
+
+            std::srand(1);
+            for (size_t j = 0; j < mInput.size(); ++j)
+            {
+                mInput[j] = SampleType(std::rand()) / SampleType(RAND_MAX) - SampleType(.5);
+            }
+            for (int c = 0; c < inNumChannels; ++c)
+            {
+                mInputChannels[c]   = &mInput[c * inBlockSize];
+                mOutputChannels[c]  = &mOutput[c * inBlockSize];
+            }
+            mNumChannels    = inNumChannels;
+            mNumSamples     = inBlockSize;
+        }
+
+    public:
+        std::vector<SampleType> mInput;
+        std::vector<SampleType> mOutput;
+        std::vector<const SampleType*> mInputChannels;
+        std::vector<SampleType*> mOutputChannels;
+        int mNumChannels;
+        int mNumSamples;
+    };
+
+    // -------------------------------------------------------------------------
+
+    /*!
+        GainType::process over each channel, either settled on a gain other than unity
+        (unity only copies), or ramping towards a target that flips at each block.
+        GainType is dsp::Gain, or dsp::reference::Gain, whose case names are then prefixed with inPrefix.
+    */
+    template<typename SampleType, class GainType = dsp::Gain>
+    class GainCase : public Case
+    {
+    public:
+        explicit GainCase(bool inRamping, const char* inPrefix = "")
+            : mPrefix(inPrefix)
+            , mRamping(inRamping)
+            , mTarget(0)
+        {
+            mPorts[0].mTargetGain = .5;
+            mPorts[1].mTargetGain = 2.;
+        }
+
+    public: // Case
+        virtual juce::String getName() const
+        {
+            return mPrefix + (mRamping ? "gain.ramping/" : "gain.settled/") + getTypeName(SampleType());
+        }
+        virtual void prepare(int inNumChannels, int inBlockSize, const Options& inOptions)
+        {
+            mBuffers.prepare(inNumChannels, inBlockSize);
+            for (int c = 0; c < inNumChannels; ++c)
+            {
+                dsp::Gain::reset(mStates[c], inOptions.mSamplerate);
+                mStates[c].mCurrentGain = SampleType(mPorts[0].mTargetGain);
+            }
+            mTarget = 0;
+        }
+        virtual void process()
+        {
+            mTarget ^= mRamping ? 1 : 0;
+            for (int c = 0; c < mBuffers.mNumChannels; ++c)
+            {
+                GainType::process(mBuffers.mInputChannels[c], mBuffers.mOutputChannels[c], mBuffers.mNumSamples,
+                                  mPorts[mTarget], mStates[c]);
+            }
+        }
+
+    private:
+        const juce::String mPrefix;
+        const bool mRamping;
+        int mTarget;
+        dsp::Gain::Port mPorts[2];
+        dsp::Gain::State<SampleType> mStates[plugin::gNumMaxChannels];
+        Buffers<SampleType> mBuffers;
+    };
+
+    // -------------------------------------------------------------------------
+
+    /*!
+        IIRType::process over each channel, with a 1 kHz bell.
+        IIRType is dsp::IIR, or dsp::reference::IIR, whose case names are then prefixed with inPrefix.
+    */
+    template<typename SampleType, class IIRType = dsp::IIR>
+    class IIRCase : public Case
+    {
+    public:
+        explicit IIRCase(const char* inPrefix = "")
+            : mPrefix(inPrefix)
+        {}
+
+    public: // Case
+        virtual juce::String getName() const
+        {
+            return mPrefix + "iir/" + getTypeName(SampleType());
+        }
+        virtual void prepare(int inNumChannels, int inBlockSize, const Options& inOptions)
+        {
+            mBuffers.prepare(inNumChannels, inBlockSize);
+            mPort = makeBell(inOptions.mSamplerate, 1000., 1., 6.);
+            for (int c = 0; c < inNumChannels; ++c)
+            {
+                dsp::IIR::reset(mStates[c]);
+            }
+        }
+        virtual void process()
+        {
+            for (int c = 0; c < mBuffers.mNumChannels; ++c)
+            {
+                IIRType::process(mBuffers.mInputChannels[c], mBuffers.mOutputChannels[c], mBuffers.mNumSamples,
+                                 mPort, mStates[c]);
+            }
+        }
+
+    private:
+        const juce::String mPrefix;
+        dsp::IIR::Port mPort;
+        dsp::IIR::State<SampleType> mStates[plugin::gNumMaxChannels];
+        Buffers<SampleType> mBuffers;
+    };
+
+    // -------------------------------------------------------------------------
+
+    /*!
+        A plugin processState, found by argument dependent lookup as Processor finds it,
+        on Ports made by inMakePorts at the samplerate the cells run at.
+        inMinSamplerate is the one the plugin passes to enableOversampling, if any.
+    */
+    template<class PortsType, template<typename> class StateType, typename SampleType>
+    class ProcessStateCase : public Case
+    {
+    public:
+        typedef PortsType (*MakePorts)(double inSamplerate);
+
+    public:
+        ProcessStateCase(const juce::String& inName, MakePorts inMakePorts, double inMinSamplerate = 0.)
+            : mName(inName)
+            , mMakePorts(inMakePorts)
+            , mMinSamplerate(inMinSamplerate)
+        {}
+
+    public: // Case
+        virtual juce::String getName() const
+        {
+            return mName + "/" + getTypeName(SampleType());
+        }
+        virtual void prepare(int inNumChannels, int inBlockSize, const Options& inOptions)
+        {
+            mBuffers.prepare(inNumChannels, inBlockSize);
+
+            mState = new StateType<SampleType>;
+            mState->mSamplerate     = inOptions.mSamplerate;
+            mState->mOversampling   = dsp::Oversampler::factor(inOptions.mSamplerate, mMinSamplerate);
+            mState->mMaxNumSamples  = inBlockSize;
+            mState->mWorkers        = inOptions.mWorkers;
+            resetState(*mState);
+
+            mPorts = mMakePorts(inOptions.mSamplerate * mState->mOversampling);
+        }
+        virtual void process()
+        {
+            processState(&mBuffers.mInputChannels[0], mBuffers.mNumChannels,
+                         &mBuffers.mOutputChannels[0], mBuffers.mNumChannels,
+                         mBuffers.mNumSamples, mPorts, *mState);
+        }
+
+    private:
+        const juce::String mName;
+        const MakePorts mMakePorts;
+        const double mMinSamplerate;
+        PortsType mPorts;
+        juce::ScopedPointer<StateType<SampleType> > mState;
+        Buffers<SampleType> mBuffers;
+    };
+}
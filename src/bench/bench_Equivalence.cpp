@@ -0,0 +1,596 @@
+/*!
+ * \file       bench_Equivalence.cpp
+ * Copyright   Eiosis 2014
+ */
+
+#include "bench/bench_Equivalence.h"
+#include "bench/bench_Cases.hpp"
+#include "framework/framework_Reference.h"
+
+#include <cstdio>
+#include <limits>
+
+namespace bench
+{
+    enum { numBlocksPerTrial = 4, preRollLength = 256, numCascadeSections = 6 };
+
+    typedef dsp::IIRCascade<numCascadeSections> Cascade;
+
+    /*!
+        Bounds of each check, for float32 and float64 cells, set from the worst of seeds 1 to 40,
+        3 to 4 dB away from it for float32, so that they record the precision of the cells as they are, and fail the changes that lose some.
+        float32 cells share the rounding noise of the scalar form, which grows large for the biquads
+        with the lowest poles the plugins map to, and mMaxExcess checks their own share of it.
+        float32 BlockIIR runs the IIR cell, so its bounds are those of iir. Every float32 cell
+        stays within 3 dB of the scalar rounding noise.
+        float64 bounds leave about 10 dB for a different evaluation order. All are measured with floating
+        point contraction off: multiply-adds fused in the scalar forms only add 25 dB to the multiiir excess.
+    */
+    inline Bounds getBounds(const juce::String& inKernel, bool inIsDouble)
+    {
+        static const double none = std::numeric_limits<double>::infinity();
+        static const struct
+        {
+            const char* mKernel;
+            Bounds mBounds[2];
+        }
+        bounds[] =
+        {
+            { "gain",       { { 6e-7, 132., 3. },       { 3e-13, 250., none } } },
+            { "iir",        { { 5e-3, 26., 3. },        { 1e-10, 185., none } } },
+            { "blockiir",   { { 7e-3, 28., 3. },        { 4e-11, 185., none } } },
+            { "multiiir",   { { 7e-3, 29., 3. },        { 1e-10, 185., none } } },
+            { "cascade",    { { .13, 17., 3. },         { 4e-10, 185., none } } },
+            { "sincos",     { { 0., none, 0. },         { 2e-15, 310., none } } },
+            { "decibels",   { { 1.7e-5, 144., 3. },     { 1e-13, 308., none } } },
+        };
+
+        for (int i = 0; i < juce::numElementsInArray(bounds); ++i)
+        {
+            if (inKernel == bounds[i].mKernel)
+            {
+                return bounds[i].mBounds[inIsDouble];
+            }
+        }
+        jassertfalse;
+        const Bounds noBounds = { 0., none, 0. };
+        return noBounds;
+    }
+
+    // -------------------------------------------------------------------------
+
+    /*!
+        The same input, as processed by the optimized cell and by the reference cell in SampleType,
+        and its exact copy as processed by the reference cell in float64.
+    */
+    template<typename SampleType>
+    struct Signals
+    {
+        /*!
+            Noise from full scale down to -60 dB.
+        */
+        void randomize(juce::Random& ioRandom, int inNumSamples)
+        {
+            const double level = std::pow(10., -3. * ioRandom.nextDouble());
+            mOptimized.resize(inNumSamples);
+            mScalar.resize(inNumSamples);
+            mReference.resize(inNumSamples);
+            for (int j = 0; j < inNumSamples; ++j)
+            {
+                mOptimized[j]   = SampleType(level * (2. * ioRandom.nextDouble() - 1.));
+                mScalar[j]      = mOptimized[j];
+                mReference[j]   = double(mOptimized[j]);
+            }
+        }
+
+        std::vector<SampleType> mOptimized;
+        std::vector<SampleType> mScalar;
+        std::vector<double> mReference;
+    };
+
+    // -------------------------------------------------------------------------
+
+    /*!
+        Worst maximum error, SNR and excess over the trials, each trial being measured over all
+        of its blocks and channels. The excess is the error power of the optimized cell over the one
+        of the scalar form in the same precision, or of one ulp of rounding when larger;
+        it is only measured for float32, the scalar float64 form being the reference itself.
+    */
+    class ErrorMeter
+    {
+    public:
+        ErrorMeter()
+            : mMaxError(0.)
+            , mSNR(std::numeric_limits<double>::infinity())
+            , mExcess(-std::numeric_limits<double>::infinity())
+            , mSignal(0.)
+            , mError(0.)
+            , mScalarError(0.)
+        {}
+
+    public:
+        template<typename SampleType>
+        void add(const Signals<SampleType>& inSignals, int inNumSamples)
+        {
+            for (int j = 0; j < inNumSamples; ++j)
+            {
+                const double reference      = inSignals.mReference[j];
+                const double error          = double(inSignals.mOptimized[j]) - reference;
+                const double scalarError    = double(inSignals.mScalar[j]) - reference;
+                mMaxError                   = std::max(mMaxError, std::abs(error));
+                mSignal                    += reference * reference;
+                mError                     += error * error;
+                mScalarError               += scalarError * scalarError;
+            }
+        }
+        template<typename SampleType>
+        void endTrial(SampleType)
+        {
+            if (mError > 0.)
+            {
+                mSNR = std::min(mSNR, 10. * std::log10(mSignal / mError));
+            }
+            if (sizeof(SampleType) < sizeof(double) && mSignal > 0.)
+            {
+                const double ulp    = std::numeric_limits<SampleType>::epsilon();
+                const double floor  = std::max(mScalarError, mSignal * ulp * ulp);
+                mExcess             = std::max(mExcess, 10. * std::log10(std::max(mError, floor) / floor));
+            }
+            mSignal         = 0.;
+            mError          = 0.;
+            mScalarError    = 0.;
+        }
+
+    public:
+        template<typename SampleType>
+        Check makeCheck(const juce::String& inKernel, SampleType) const
+        {
+            Check check;
+            check.mName     = inKernel + "/" + getTypeName(SampleType());
+            check.mMaxError = mMaxError;
+            check.mSNR      = mSNR;
+            check.mExcess   = mExcess;
+            check.mBounds   = getBounds(inKernel, sizeof(SampleType) == sizeof(double));
+            return check;
+        }
+
+    private:
+        double mMaxError;
+        double mSNR;
+        double mExcess;
+        double mSignal;
+        double mError;
+        double mScalarError;
+    };
+
+    // -------------------------------------------------------------------------
+
+    inline double randomSamplerate(juce::Random& ioRandom)
+    {
+        static const double samplerates[] = { 44100., 48000., 88200., 96000., 176400., 192000. };
+        return samplerates[ioRandom.nextInt(juce::numElementsInArray(samplerates))];
+    }
+
+    inline double randomLog(juce::Random& ioRandom, double inMin, double inMax)
+    {
+        return inMin * std::pow(inMax / inMin, ioRandom.nextDouble());
+    }
+
+    /*!
+        Bells over the ranges of the Rocky and Filter parameters.
+    */
+    inline dsp::IIR::Port randomBell(juce::Random& ioRandom, double inSamplerate)
+    {
+        return makeBell(inSamplerate, randomLog(ioRandom, 20., 20000.), randomLog(ioRandom, .1, 10.),
+                        48. * ioRandom.nextDouble() - 24.);
+    }
+
+    inline dsp::Gain::Port randomGain(juce::Random& ioRandom)
+    {
+        const dsp::Gain::Port port = { dsp::dBToLinear(36. * ioRandom.nextDouble() - 24.) };
+        return port;
+    }
+
+    /*!
+        Some very short blocks, some around usual host sizes, and some long enough for the time-parallel forms.
+    */
+    inline int randomBlockSize(juce::Random& ioRandom)
+    {
+        static const int maxSizes[] = { 8, 100, 600, 4096 };
+        return 1 + ioRandom.nextInt(maxSizes[ioRandom.nextInt(juce::numElementsInArray(maxSizes))]);
+    }
+
+    /*!
+        The memories a pre roll of noise leaves the biquad with, rounded to SampleType.
+    */
+    template<typename SampleType>
+    inline dsp::IIR::State<SampleType> randomState(juce::Random& ioRandom, const dsp::IIR::Port& inPort)
+    {
+        std::vector<double> preRoll(preRollLength);
+        for (int j = 0; j < preRollLength; ++j)
+        {
+            preRoll[j] = 2. * ioRandom.nextDouble() - 1.;
+        }
+        dsp::IIR::State<double> state = { 0., 0. };
+        dsp::reference::IIR::process(&preRoll[0], &preRoll[0], preRollLength, inPort, state);
+
+        const dsp::IIR::State<SampleType> res = { SampleType(state.mX), SampleType(state.mY) };
+        return res;
+    }
+
+    template<typename SampleType>
+    inline dsp::IIR::State<double> toReference(const dsp::IIR::State<SampleType>& inState)
+    {
+        const dsp::IIR::State<double> res = { double(inState.mX), double(inState.mY) };
+        return res;
+    }
+
+    template<typename SampleType>
+    inline dsp::Gain::State<double> toReference(const dsp::Gain::State<SampleType>& inState)
+    {
+        const dsp::Gain::State<double> res = { double(inState.mCurrentGain), double(inState.mDecay) };
+        return res;
+    }
+
+    // -------------------------------------------------------------------------
+
+    /*!
+        The target may change at each block, and the gain starts settled or not.
+    */
+    template<typename SampleType>
+    inline Check checkGain(juce::Random& ioRandom, int inNumTrials)
+    {
+        ErrorMeter meter;
+        Signals<SampleType> signals;
+
+        for (int t = 0; t < inNumTrials; ++t)
+        {
+            dsp::Gain::Port port = randomGain(ioRandom);
+            dsp::Gain::State<SampleType> state;
+            dsp::Gain::reset(state, randomSamplerate(ioRandom));
+            state.mCurrentGain = SampleType(ioRandom.nextBool() ? port.mTargetGain : randomGain(ioRandom).mTargetGain);
+            dsp::Gain::State<SampleType> scalarState    = state;
+            dsp::Gain::State<double> referenceState     = toReference(state);
+
+            for (int b = 0; b < numBlocksPerTrial; ++b)
+            {
+                if (ioRandom.nextBool())
+                {
+                    port = randomGain(ioRandom);
+                }
+                const int numSamples = randomBlockSize(ioRandom);
+                signals.randomize(ioRandom, numSamples);
+
+                dsp::Gain::process(&signals.mOptimized[0], &signals.mOptimized[0], numSamples, port, state);
+                dsp::reference::Gain::process(&signals.mScalar[0], &signals.mScalar[0], numSamples,
+                                              port, scalarState);
+                dsp::reference::Gain::process(&signals.mReference[0], &signals.mReference[0], numSamples,
+                                              port, referenceState);
+                meter.add(signals, numSamples);
+            }
+            meter.endTrial(SampleType());
+        }
+        return meter.makeCheck("gain", SampleType());
+    }
+
+    /*!
+        A mono biquad cell, such as IIR or BlockIIR, processing in place on the IIR State.
+    */
+    template<class CellType, typename SampleType>
+    inline Check checkIIR(const juce::String& inKernel, juce::Random& ioRandom, int inNumTrials)
+    {
+        ErrorMeter meter;
+        Signals<SampleType> signals;
+
+        for (int t = 0; t < inNumTrials; ++t)
+        {
+            const dsp::IIR::Port port               = randomBell(ioRandom, randomSamplerate(ioRandom));
+            dsp::IIR::State<SampleType> state       = randomState<SampleType>(ioRandom, port);
+            dsp::IIR::State<SampleType> scalarState = state;
+            dsp::IIR::State<double> referenceState  = toReference(state);
+
+            for (int b = 0; b < numBlocksPerTrial; ++b)
+            {
+                const int numSamples = randomBlockSize(ioRandom);
+                signals.randomize(ioRandom, numSamples);
+
+                CellType::process(&signals.mOptimized[0], &signals.mOptimized[0], numSamples, port, state);
+                dsp::reference::IIR::process(&signals.mScalar[0], &signals.mScalar[0], numSamples,
+                                             port, scalarState);
+                dsp::reference::IIR::process(&signals.mReference[0], &signals.mReference[0], numSamples,
+                                             port, referenceState);
+                meter.add(signals, numSamples);
+            }
+            meter.endTrial(SampleType());
+        }
+        return meter.makeCheck(inKernel, SampleType());
+    }
+
+    /*!
+        One to MultiIIR::numLanes channels sharing a Port, each with its own memories.
+    */
+    template<typename SampleType>
+    inline Check checkMultiIIR(juce::Random& ioRandom, int inNumTrials)
+    {
+        enum { numLanes = dsp::MultiIIR::numLanes };
+
+        ErrorMeter meter;
+        Signals<SampleType> signals[numLanes];
+
+        for (int t = 0; t < inNumTrials; ++t)
+        {
+            const int numChannels           = 1 + ioRandom.nextInt(numLanes);
+            const dsp::IIR::Port port       = randomBell(ioRandom, randomSamplerate(ioRandom));
+
+            dsp::MultiIIR::State<SampleType> state;
+            dsp::MultiIIR::reset(state);
+            dsp::IIR::State<SampleType> scalarStates[numLanes];
+            dsp::IIR::State<double> referenceStates[numLanes];
+            for (int c = 0; c < numChannels; ++c)
+            {
+                scalarStates[c]     = randomState<SampleType>(ioRandom, port);
+                referenceStates[c]  = toReference(scalarStates[c]);
+                state.mX[c]         = scalarStates[c].mX;
+                state.mY[c]         = scalarStates[c].mY;
+            }
+
+            for (int b = 0; b < numBlocksPerTrial; ++b)
+            {
+                const int numSamples = randomBlockSize(ioRandom);
+                SampleType* channels[numLanes];
+                for (int c = 0; c < numChannels; ++c)
+                {
+                    signals[c].randomize(ioRandom, numSamples);
+                    channels[c] = &signals[c].mOptimized[0];
+                }
+
+                dsp::MultiIIR::process(channels, channels, numChannels, numSamples, port, state);
+                for (int c = 0; c < numChannels; ++c)
+                {
+                    dsp::reference::IIR::process(&signals[c].mScalar[0], &signals[c].mScalar[0], numSamples,
+                                                 port, scalarStates[c]);
+                    dsp::reference::IIR::process(&signals[c].mReference[0], &signals[c].mReference[0], numSamples,
+                                                 port, referenceStates[c]);
+                    meter.add(signals[c], numSamples);
+                }
+            }
+            meter.endTrial(SampleType());
+        }
+        return meter.makeCheck("multiiir", SampleType());
+    }
+
+    /*!
+        The chain IIRCascade fuses: an input Gain, the sections and an output Gain, one after the other.
+    */
+    template<typename SampleType>
+    struct ReferenceCascade
+    {
+        template<typename InputType>
+        void set(const dsp::IIRCascade<numCascadeSections>::State<InputType>& inState, int inLane)
+        {
+            mInputGain.mCurrentGain     = SampleType(inState.mInputGain[inLane]);
+            mInputGain.mDecay           = SampleType(inState.mGainDecay);
+            mOutputGain.mCurrentGain    = SampleType(inState.mOutputGain[inLane]);
+            mOutputGain.mDecay          = SampleType(inState.mGainDecay);
+            for (int k = 0; k < numCascadeSections; ++k)
+            {
+                mSections[k].mX = SampleType(inState.mSections[k].mX[inLane]);
+                mSections[k].mY = SampleType(inState.mSections[k].mY[inLane]);
+            }
+        }
+        void process(SampleType* ioSamples, int inNumSamples, const dsp::Gain::Port& inInputGain,
+                     const dsp::IIR::Port* inSections, const dsp::Gain::Port& inOutputGain)
+        {
+            dsp::reference::Gain::process(ioSamples, ioSamples, inNumSamples, inInputGain, mInputGain);
+            for (int k = 0; k < numCascadeSections; ++k)
+            {
+                dsp::reference::IIR::process(ioSamples, ioSamples, inNumSamples, inSections[k], mSections[k]);
+            }
+            dsp::reference::Gain::process(ioSamples, ioSamples, inNumSamples, inOutputGain, mOutputGain);
+        }
+
+        dsp::Gain::State<SampleType> mInputGain;
+        dsp::IIR::State<SampleType> mSections[numCascadeSections];
+        dsp::Gain::State<SampleType> mOutputGain;
+    };
+
+    /*!
+        The Rocky cascade against its ReferenceCascade.
+        Gain targets may change at each block; section Ports stay the same over the trial,
+        as coefficient ramps are an interpolation the cascade makes, not an approximation of the reference.
+        Mono float64 trials cover the time-parallel path of long blocks.
+    */
+    template<typename SampleType>
+    inline Check checkCascade(juce::Random& ioRandom, int inNumTrials)
+    {
+        enum { numLanes = Cascade::numLanes };
+
+        ErrorMeter meter;
+        Signals<SampleType> signals[numLanes];
+
+        for (int t = 0; t < inNumTrials; ++t)
+        {
+            const int numChannels   = 1 + ioRandom.nextInt(numLanes);
+            const double samplerate = randomSamplerate(ioRandom);
+
+            dsp::IIR::Port ports[numCascadeSections];
+            const dsp::IIR::Port* sections[numCascadeSections];
+            for (int k = 0; k < numCascadeSections; ++k)
+            {
+                ports[k]    = randomBell(ioRandom, samplerate);
+                sections[k] = &ports[k];
+            }
+            dsp::Gain::Port inputGain   = randomGain(ioRandom);
+            dsp::Gain::Port outputGain  = randomGain(ioRandom);
+
+            Cascade::State<SampleType> state;
+            Cascade::reset(state, samplerate);
+            ReferenceCascade<SampleType> scalars[numLanes];
+            ReferenceCascade<double> references[numLanes];
+            for (int c = 0; c < numChannels; ++c)
+            {
+                state.mInputGain[c]     = SampleType(randomGain(ioRandom).mTargetGain);
+                state.mOutputGain[c]    = SampleType(outputGain.mTargetGain);
+                for (int k = 0; k < numCascadeSections; ++k)
+                {
+                    const dsp::IIR::State<SampleType> lane = randomState<SampleType>(ioRandom, ports[k]);
+                    state.mSections[k].mX[c] = lane.mX;
+                    state.mSections[k].mY[c] = lane.mY;
+                }
+                scalars[c].set(state, c);
+                references[c].set(state, c);
+            }
+
+            for (int b = 0; b < numBlocksPerTrial; ++b)
+            {
+                if (ioRandom.nextBool())
+                {
+                    inputGain   = randomGain(ioRandom);
+                    outputGain  = randomGain(ioRandom);
+                }
+                const int numSamples = randomBlockSize(ioRandom);
+                SampleType* channels[numLanes];
+                for (int c = 0; c < numChannels; ++c)
+                {
+                    signals[c].randomize(ioRandom, numSamples);
+                    channels[c] = &signals[c].mOptimized[0];
+                }
+
+                Cascade::process(channels, channels, numChannels, numSamples, inputGain, sections, outputGain, state);
+                for (int c = 0; c < numChannels; ++c)
+                {
+                    scalars[c].process(&signals[c].mScalar[0], numSamples, inputGain, ports, outputGain);
+                    references[c].process(&signals[c].mReference[0], numSamples, inputGain, ports, outputGain);
+                    meter.add(signals[c], numSamples);
+                }
+            }
+            meter.endTrial(SampleType());
+        }
+        return meter.makeCheck("cascade", SampleType());
+    }
+
+    // -------------------------------------------------------------------------
+
+    /*!
+        The mappers' dsp::gSinCosTable against std::sin and std::cos,
+        over normalized frequencies spread on a log scale from 1e-6 to the Nyquist frequency.
+    */
+    inline Check checkSinCos(juce::Random& ioRandom, int inNumTrials)
+    {
+        enum { numFrequencies = 4096 };
+
+        ErrorMeter meter;
+        Signals<double> signals;
+        signals.mOptimized.resize(numFrequencies);
+        signals.mReference.resize(numFrequencies);
+        for (int t = 0; t < inNumTrials; ++t)
+        {
+            for (int j = 0; j < numFrequencies; j += 2)
+            {
+                const double frequency  = randomLog(ioRandom, 1e-6, .5);
+                dsp::gSinCosTable.sinCos(frequency, signals.mOptimized[j], signals.mOptimized[j + 1]);
+                signals.mReference[j]       = std::sin(dsp::twoPi_64 * frequency);
+                signals.mReference[j + 1]   = std::cos(dsp::twoPi_64 * frequency);
+            }
+            signals.mScalar = signals.mReference;
+            meter.add(signals, numFrequencies);
+            meter.endTrial(double());
+        }
+        return meter.makeCheck("sincos", double());
+    }
+
+    /*!
+        dsp::dBToLinear and dsp::linearTodB, which the mappers and meters use, against std::pow and std::log10,
+        over -120 to +24 dB.
+    */
+    template<typename SampleType>
+    inline Check checkDecibels(juce::Random& ioRandom, int inNumTrials)
+    {
+        enum { numValues = 4096 };
+
+        ErrorMeter meter;
+        Signals<SampleType> signals;
+        signals.mOptimized.resize(numValues);
+        signals.mScalar.resize(numValues);
+        signals.mReference.resize(numValues);
+        for (int t = 0; t < inNumTrials; ++t)
+        {
+            for (int j = 0; j < numValues; j += 2)
+            {
+                const SampleType dB         = SampleType(144. * ioRandom.nextDouble() - 120.);
+                const SampleType linear     = SampleType(randomLog(ioRandom, 1e-6, 16.));
+                signals.mOptimized[j]       = dsp::dBToLinear(dB);
+                signals.mOptimized[j + 1]   = dsp::linearTodB(linear);
+                signals.mScalar[j]          = std::pow(SampleType(10.), SampleType(.05) * dB);
+                signals.mScalar[j + 1]      = SampleType(20.) * std::log10(linear);
+                signals.mReference[j]       = std::pow(10., .05 * double(dB));
+                signals.mReference[j + 1]   = 20. * std::log10(double(linear));
+            }
+            meter.add(signals, numValues);
+            meter.endTrial(SampleType());
+        }
+        return meter.makeCheck("decibels", SampleType());
+    }
+
+    // -------------------------------------------------------------------------
+
+    bool Check::passed() const
+    {
+        return mMaxError <= mBounds.mMaxError && mSNR >= mBounds.mMinSNR && mExcess <= mBounds.mMaxExcess;
+    }
+
+    // -------------------------------------------------------------------------
+
+    Equivalence::Equivalence(int inNumTrials, juce::int64 inSeed)
+        : mNumTrials(inNumTrials)
+        , mSeed(inSeed)
+    {}
+
+    template<typename SampleType>
+    inline void addChecks(juce::Array<Check>& ioChecks, juce::Random& ioRandom, int inNumTrials)
+    {
+        ioChecks.add(checkGain<SampleType>(ioRandom, inNumTrials));
+        ioChecks.add(checkIIR<dsp::IIR, SampleType>("iir", ioRandom, inNumTrials));
+        ioChecks.add(checkIIR<dsp::BlockIIR, SampleType>("blockiir", ioRandom, inNumTrials));
+        ioChecks.add(checkMultiIIR<SampleType>(ioRandom, inNumTrials));
+        ioChecks.add(checkCascade<SampleType>(ioRandom, inNumTrials));
+    }
+
+    /*!
+        Cells run with denormals flushed, as Processor::processBlock does.
+    */
+    juce::Array<Check> Equivalence::run()
+    {
+        const dsp::ScopedNoDenormals noDenormals;
+
+        juce::Random random(mSeed);
+        juce::Array<Check> checks;
+        addChecks<dsp::float32>(checks, random, mNumTrials);
+        addChecks<dsp::float64>(checks, random, mNumTrials);
+        checks.add(checkSinCos(random, mNumTrials));
+        checks.add(checkDecibels<dsp::float32>(random, mNumTrials));
+        checks.add(checkDecibels<dsp::float64>(random, mNumTrials));
+
+        std::printf("%-32s %12s %12s %10s %10s %10s %10s\n", "check", "max error", "bound", "SNR", "bound",
+                    "excess", "bound");
+        for (int i = 0; i < checks.size(); ++i)
+        {
+            const Check& check = checks.getReference(i);
+            std::printf("%-32s %12.3g %12.3g %10.1f %10.1f %10.1f %10.1f%s\n", check.mName.toRawUTF8(),
+                        check.mMaxError, check.mBounds.mMaxError, check.mSNR, check.mBounds.mMinSNR,
+                        check.mExcess, check.mBounds.mMaxExcess, check.passed() ? "" : " failed");
+        }
+        std::printf("\n");
+        return checks;
+    }
+
+    int Equivalence::countFailures(const juce::Array<Check>& inChecks)
+    {
+        int numFailures = 0;
+        for (int i = 0; i < inChecks.size(); ++i)
+        {
+            numFailures += inChecks[i].passed() ? 0 : 1;
+        }
+        return numFailures;
+    }
+}
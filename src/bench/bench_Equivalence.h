@@ -0,0 +1,68 @@
+/*!
+ * \file       bench_Equivalence.h
+ * Copyright   Eiosis 2014
+ */
+
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace bench
+{
+    /*!
+        Largest error an optimized cell may show against the reference:
+        mMaxError is an absolute difference on full scale signals, mMinSNR and mMaxExcess are in dB.
+    */
+    struct Bounds
+    {
+        double mMaxError;
+        double mMinSNR;
+        double mMaxExcess;
+    };
+
+    /*!
+        The worst error one optimized cell showed over all trials against the float64 reference,
+        mSNR being the reference power over the error power, and mExcess how much larger
+        the error power is than the one of the scalar form in the same precision.
+    */
+    struct Check
+    {
+        juce::String mName;
+        double mMaxError;
+        double mSNR;
+        double mExcess;
+        Bounds mBounds;
+
+        bool passed() const;
+    };
+
+    // -------------------------------------------------------------------------
+
+    /*!
+        Equivalence runs the optimized cells and their dsp::reference counterparts
+        on the same random Ports, States and signals, and checks how far apart their outputs are.
+        Each trial draws a samplerate, Ports in the ranges the plugins map to, a starting State
+        (gains away from their targets, filter memories from a random pre roll),
+        and a few blocks of noise of random lengths and level.
+        The reference runs in float64 from the exact same inputs, so that for float64 cells
+        the error is the one of the optimized arithmetic only. float32 cells are also compared
+        to the reference cells run in float32, as they can't be more precise than the scalar form.
+    */
+    class Equivalence
+    {
+    public:
+        Equivalence(int inNumTrials, juce::int64 inSeed);
+
+    public:
+        /*!
+            Runs all checks, printing them as they come.
+        */
+        juce::Array<Check> run();
+
+        static int countFailures(const juce::Array<Check>& inChecks);
+
+    private:
+        const int mNumTrials;
+        const juce::int64 mSeed;
+    };
+}
@@ -0,0 +1,253 @@
+/*!
+ * \file       bench_Main.cpp
+ * Copyright   Eiosis 2014
+ */
+
+/*
+    Microbenchmarks of the cells and of each plugin processState, in both precisions,
+    over channel counts and block sizes from 1 to 8192 samples.
+    The optimized cells are first checked against the dsp::reference ones (see bench::Equivalence):
+    the tool fails when they differ by more than their bounds, or when they got slower than a baseline.
+    bench_Baseline.json is the reference baseline, measured on the build machine with -s 5 -o: it is to be
+    rewritten along with the changes that make a case faster or slower on purpose, or with the machine.
+
+    bench [-e] [-f filter] [-r samplerate] [-s sweeps] [-n runs] [-w workers] [-o results.json]
+          [-c baseline.json [-t percent]]
+
+        -e  only runs the equivalence checks
+        -f  only runs the cases whose name contains filter, such as "rocky" or "float32"
+        -r  samplerate, 48000 by default
+        -s  passes over all the measurements, 3 by default
+        -n  timed runs per measurement and sweep, 5 by default, the median and spread
+            of the runs of all sweeps being reported
+        -w  number of worker threads processState may use, none by default
+        -o  writes the results as JSON, to be used as a baseline later
+        -c  compares the results to a baseline, and fails when any case got slower than the tolerance,
+            by the median change of its results
+        -t  tolerance of the comparison, 10 percent by default, raised to three times the spread
+            of the measurements on noisier runs
+
+    Build as a console tool, linked with the framework and the JUCE core and audio_basics modules.
+    Plugin Ports are set as their mappers would, with every IIR section as a bell:
+    a biquad costs the same whatever its shape.
+*/
+
+#include "bench/bench_Cases.hpp"
+#include "bench/bench_Equivalence.h"
+#include "framework/framework_Workers.h"
+#include "shell/shell_Process.hpp"
+#include "filter/filter_Process.hpp"
+#include "rocky/rocky_Process.hpp"
+
+#include <iostream>
+
+namespace bench
+{
+    /*!
+        As RockyProcessor enables it, for offline renders.
+    */
+    static const double gRockyMinSamplerate = 88200.;
+
+    inline shell::ShellPorts makeShellPorts(double)
+    {
+        const shell::ShellPorts ports = { { dsp::dBToLinear(-3.) }, { dsp::dBToLinear(3.) } };
+        return ports;
+    }
+
+    inline filter::FilterPorts makeFilterPorts(double inSamplerate)
+    {
+        const filter::FilterPorts ports =
+        {
+            { dsp::dBToLinear(-3.) }, makeBell(inSamplerate, 1000., 1., 6.), { dsp::dBToLinear(3.) }
+        };
+        return ports;
+    }
+
+    inline rocky::RockyPorts makeRockyPorts(double inSamplerate)
+    {
+        const rocky::RockyPorts ports =
+        {
+            { dsp::dBToLinear(-3.) },
+            makeBell(inSamplerate, 30., .7, -6.),
+            makeBell(inSamplerate, 100., .7, 3.),
+            makeBell(inSamplerate, 500., 2., -4.),
+            makeBell(inSamplerate, 3000., 2., 4.),
+            makeBell(inSamplerate, 10000., .7, 3.),
+            makeBell(inSamplerate, 18000., .7, -6.),
+            { dsp::dBToLinear(3.) },
+        };
+        return ports;
+    }
+
+    template<typename SampleType>
+    inline void addCases(Suite& ioSuite)
+    {
+        ioSuite.add(new GainCase<SampleType>(false));
+        ioSuite.add(new GainCase<SampleType>(true));
+        ioSuite.add(new IIRCase<SampleType>);
+        ioSuite.add(new GainCase<SampleType, dsp::reference::Gain>(false, "reference."));
+        ioSuite.add(new GainCase<SampleType, dsp::reference::Gain>(true, "reference."));
+        ioSuite.add(new IIRCase<SampleType, dsp::reference::IIR>("reference."));
+        ioSuite.add(new ProcessStateCase<shell::ShellPorts, shell::ShellState, SampleType>("shell", &makeShellPorts));
+        ioSuite.add(new ProcessStateCase<filter::FilterPorts, filter::FilterState, SampleType>("filter",
+                                                                                              &makeFilterPorts));
+        ioSuite.add(new ProcessStateCase<rocky::RockyPorts, rocky::RockyState, SampleType>("rocky", &makeRockyPorts));
+        ioSuite.add(new ProcessStateCase<rocky::RockyPorts, rocky::RockyState, SampleType>("rocky.offline",
+                                                                                          &makeRockyPorts,
+                                                                                          gRockyMinSamplerate));
+    }
+
+    // -------------------------------------------------------------------------
+
+    enum { numEquivalenceTrials = 200, equivalenceSeed = 1 };
+
+    struct Arguments
+    {
+        bool mCheckOnly;
+        Options mOptions;
+        int mNumWorkers;
+        juce::File mOutput;
+        juce::File mBaseline;
+        double mTolerance;
+    };
+
+    inline void printUsage()
+    {
+        std::cerr << "usage: bench [-e] [-f filter] [-r samplerate] [-s sweeps] [-n runs] [-w workers] [-o results.json]"
+                     " [-c baseline.json [-t percent]]" << std::endl;
+    }
+
+    inline bool parseArguments(const juce::StringArray& inArguments, Arguments& outArguments)
+    {
+        const juce::File cwd = juce::File::getCurrentWorkingDirectory();
+
+        outArguments.mCheckOnly             = false;
+        outArguments.mOptions.mFilter       = juce::String::empty;
+        outArguments.mOptions.mSamplerate   = 48000.;
+        outArguments.mOptions.mNumSweeps    = 3;
+        outArguments.mOptions.mNumRuns      = 5;
+        outArguments.mOptions.mRunLength    = 1 << 17;
+        outArguments.mOptions.mWorkers      = 0;
+        outArguments.mNumWorkers            = 0;
+        outArguments.mOutput                = juce::File::nonexistent;
+        outArguments.mBaseline              = juce::File::nonexistent;
+        outArguments.mTolerance             = .1;
+
+        for (int i = 0; i < inArguments.size(); ++i)
+        {
+            const juce::String& argument    = inArguments[i];
+            const bool hasValue             = i + 1 < inArguments.size();
+
+            if (argument == "-e")
+            {
+                outArguments.mCheckOnly = true;
+            }
+            else if (argument == "-f" && hasValue)
+            {
+                outArguments.mOptions.mFilter = inArguments[++i];
+            }
+            else if (argument == "-r" && hasValue)
+            {
+                outArguments.mOptions.mSamplerate = inArguments[++i].getDoubleValue();
+            }
+            else if (argument == "-s" && hasValue)
+            {
+                outArguments.mOptions.mNumSweeps = inArguments[++i].getIntValue();
+            }
+            else if (argument == "-n" && hasValue)
+            {
+                outArguments.mOptions.mNumRuns = inArguments[++i].getIntValue();
+            }
+            else if (argument == "-w" && hasValue)
+            {
+                outArguments.mNumWorkers = inArguments[++i].getIntValue();
+            }
+            else if (argument == "-o" && hasValue)
+            {
+                outArguments.mOutput = cwd.getChildFile(inArguments[++i]);
+            }
+            else if (argument == "-c" && hasValue)
+            {
+                outArguments.mBaseline = cwd.getChildFile(inArguments[++i]);
+            }
+            else if (argument == "-t" && hasValue)
+            {
+                outArguments.mTolerance = inArguments[++i].getDoubleValue() / 100.;
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        return outArguments.mOptions.mSamplerate > 0. && outArguments.mOptions.mNumSweeps > 0
+            && outArguments.mOptions.mNumRuns > 0
+            && outArguments.mNumWorkers >= 0 && outArguments.mTolerance >= 0.;
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+int main(int argc, char* argv[])
+{
+    juce::StringArray arguments;
+    for (int i = 1; i < argc; ++i)
+    {
+        arguments.add(juce::CharPointer_UTF8(argv[i]));
+    }
+
+    bench::Arguments args;
+    if (!bench::parseArguments(arguments, args))
+    {
+        bench::printUsage();
+        return 2;
+    }
+
+    juce::var baseline;
+    if (args.mBaseline != juce::File::nonexistent)
+    {
+        const juce::Result result = juce::JSON::parse(args.mBaseline.loadFileAsString(), baseline);
+        if (result.failed())
+        {
+            std::cerr << args.mBaseline.getFullPathName().toRawUTF8() << ": "
+                      << result.getErrorMessage().toRawUTF8() << std::endl;
+            return 1;
+        }
+    }
+
+    bench::Equivalence equivalence(bench::numEquivalenceTrials, bench::equivalenceSeed);
+    const int numFailures = bench::Equivalence::countFailures(equivalence.run());
+    if (numFailures > 0 || args.mCheckOnly)
+    {
+        std::cout << numFailures << " equivalence checks failed." << std::endl;
+        return numFailures == 0 ? 0 : 1;
+    }
+
+    juce::ScopedPointer<plugin::WorkerPool> workers;
+    if (args.mNumWorkers > 0)
+    {
+        workers = new plugin::WorkerPool(args.mNumWorkers);
+        args.mOptions.mWorkers = workers;
+    }
+
+    bench::Suite suite;
+    bench::addCases<dsp::float32>(suite);
+    bench::addCases<dsp::float64>(suite);
+
+    const juce::Array<bench::Result> results = suite.run(args.mOptions);
+
+    if (args.mOutput != juce::File::nonexistent
+        && !args.mOutput.replaceWithText(juce::JSON::toString(bench::Suite::toJSON(results, args.mOptions))))
+    {
+        std::cerr << "can't write " << args.mOutput.getFullPathName().toRawUTF8() << std::endl;
+        return 1;
+    }
+
+    if (args.mBaseline != juce::File::nonexistent)
+    {
+        const int numRegressions = bench::Suite::compare(results, baseline, args.mTolerance);
+        std::cout << numRegressions << " cases slower than the baseline." << std::endl;
+        return numRegressions == 0 ? 0 : 1;
+    }
+    return 0;
+}
@@ -0,0 +1,324 @@
+/*!
+ * \file       bench_Suite.cpp
+ * Copyright   Eiosis 2014
+ */
+
+#include "bench/bench_Suite.h"
+#include "framework/framework_SIMD.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#if JUCE_INTEL
+    #if JUCE_MSVC
+        #include <intrin.h>
+    #else
+        #include <x86intrin.h>
+    #endif
+#endif
+
+namespace bench
+{
+    /*!
+        The time stamp counter where there is one, and 0 elsewhere,
+        cycles then being estimated from the nominal cpu frequency.
+    */
+    inline juce::uint64 readCycleCounter()
+    {
+#if JUCE_INTEL
+        return __rdtsc();
+#else
+        return 0;
+#endif
+    }
+
+    struct Stamp
+    {
+        juce::int64 mTicks;
+        juce::uint64 mCycles;
+    };
+
+    inline Stamp now()
+    {
+        const Stamp stamp = { juce::Time::getHighResolutionTicks(), readCycleCounter() };
+        return stamp;
+    }
+
+    static const double warmUpSeconds   = .5;
+    static const double madToSigma      = 1.4826;   //<! Median absolute deviation to standard deviation, if normal
+    static const double noiseSigmas     = 3.;       //<! Spreads a case may be slower by before it is a regression
+
+    inline juce::String getKey(const juce::String& inName, int inNumChannels, int inBlockSize)
+    {
+        return inName + " " + juce::String(inNumChannels) + "x" + juce::String(inBlockSize);
+    }
+
+    inline double median(juce::Array<double> inValues)
+    {
+        if (inValues.size() == 0)
+        {
+            return 0.;
+        }
+        std::sort(inValues.begin(), inValues.end());
+        const int half = inValues.size() >> 1;
+        return (inValues.size() & 1) != 0 ? inValues[half] : .5 * (inValues[half - 1] + inValues[half]);
+    }
+
+    /*!
+        Standard deviation of inValues over their median, estimated from their median absolute deviation
+        so that a run disturbed by the system does not count more than any other.
+    */
+    inline double relativeSpread(const juce::Array<double>& inValues)
+    {
+        const double center = median(inValues);
+        juce::Array<double> deviations;
+        for (int i = 0; i < inValues.size(); ++i)
+        {
+            deviations.add(std::abs(inValues[i] - center));
+        }
+        return center > 0. ? madToSigma * median(deviations) / center : 0.;
+    }
+
+    /*!
+        The change of one case relative to the baseline, over all its results.
+    */
+    struct CaseChange
+    {
+        juce::String mName;
+        double mChange;
+        double mTolerance;
+    };
+
+    // -------------------------------------------------------------------------
+
+    Suite::Suite()
+    {}
+
+    Suite::~Suite()
+    {}
+
+    void Suite::add(Case* inCase)
+    {
+        mCases.add(inCase);
+    }
+
+    // -------------------------------------------------------------------------
+
+    /*!
+        Mono to 7.1.4, the 16 channels of plugin::gNumMaxChannels, and an odd count leaving SIMD lanes empty.
+    */
+    const juce::Array<int>& Suite::getNumChannels()
+    {
+        static const int numChannels[] = { 1, 2, 6, 16 };
+        static const juce::Array<int> array(numChannels, juce::numElementsInArray(numChannels));
+        return array;
+    }
+
+    /*!
+        Powers of two as most hosts use, and the odd sizes some hosts (and automation splits) produce.
+    */
+    const juce::Array<int>& Suite::getBlockSizes()
+    {
+        static const int blockSizes[] = { 1, 7, 32, 64, 100, 256, 441, 512, 1000, 1024, 2048, 4096, 8192 };
+        static const juce::Array<int> array(blockSizes, juce::numElementsInArray(blockSizes));
+        return array;
+    }
+
+    // -------------------------------------------------------------------------
+
+    /*!
+        The timed runs of one measurement, over all sweeps.
+    */
+    struct Suite::Timings
+    {
+        Case* mCase;
+        int mNumChannels;
+        int mBlockSize;
+        juce::Array<double> mSeconds;
+        juce::Array<double> mCycles;
+        double mNumSamples;         //<! Channel samples per run
+    };
+
+    juce::Array<Result> Suite::run(const Options& inOptions)
+    {
+        juce::OwnedArray<Timings> timings;
+        for (int i = 0; i < mCases.size(); ++i)
+        {
+            if (inOptions.mFilter.isNotEmpty() && !mCases[i]->getName().contains(inOptions.mFilter))
+            {
+                continue;
+            }
+            for (int c = 0; c < getNumChannels().size(); ++c)
+            {
+                for (int b = 0; b < getBlockSizes().size(); ++b)
+                {
+                    Timings* measurement        = timings.add(new Timings);
+                    measurement->mCase          = mCases[i];
+                    measurement->mNumChannels   = getNumChannels()[c];
+                    measurement->mBlockSize     = getBlockSizes()[b];
+                    measurement->mNumSamples    = 0.;
+                }
+            }
+        }
+
+        for (int s = 0; s < inOptions.mNumSweeps; ++s)
+        {
+            std::printf("sweep %d of %d\n", s + 1, inOptions.mNumSweeps);
+            std::fflush(stdout);
+            for (int i = 0; i < timings.size(); ++i)
+            {
+                measure(*timings[i], inOptions);
+            }
+        }
+
+        juce::Array<Result> results;
+        std::printf("%-32s %8s %6s %12s %16s %8s\n", "case", "channels", "block", "ns/sample", "cycles/sample", "spread");
+        for (int i = 0; i < timings.size(); ++i)
+        {
+            const Timings& measurement  = *timings[i];
+            const double seconds        = median(measurement.mSeconds);
+            const double cycles         = median(measurement.mCycles) != 0. ? median(measurement.mCycles)
+                                        : seconds * 1e6 * juce::SystemStats::getCpuSpeedInMegaherz();
+
+            Result result;
+            result.mName            = measurement.mCase->getName();
+            result.mNumChannels     = measurement.mNumChannels;
+            result.mBlockSize       = measurement.mBlockSize;
+            result.mNsPerSample     = 1e9 * seconds / measurement.mNumSamples;
+            result.mCyclesPerSample = cycles / measurement.mNumSamples;
+            result.mSpread          = relativeSpread(measurement.mSeconds);
+            std::printf("%-32s %8d %6d %12.3f %16.3f %7.1f%%\n", result.mName.toRawUTF8(), result.mNumChannels,
+                        result.mBlockSize, result.mNsPerSample, result.mCyclesPerSample, 100. * result.mSpread);
+            results.add(result);
+        }
+        return results;
+    }
+
+    /*!
+        Blocks run with denormals flushed, as Processor::processBlock does.
+        The warm up lasts for warmUpSeconds at least, so that gains reset to 0 have settled.
+    */
+    void Suite::measure(Timings& ioTimings, const Options& inOptions) const
+    {
+        Case& ioCase                = *ioTimings.mCase;
+        const int numChannels       = ioTimings.mNumChannels;
+        const int blockSize         = ioTimings.mBlockSize;
+        const int numBlocks         = std::max(1, inOptions.mRunLength / (numChannels * blockSize));
+        const int numWarmUpBlocks   = std::max(numBlocks, int(warmUpSeconds * inOptions.mSamplerate) / blockSize);
+
+        ioCase.prepare(numChannels, blockSize, inOptions);
+
+        const dsp::ScopedNoDenormals noDenormals;
+        for (int j = 0; j < numWarmUpBlocks; ++j)
+        {
+            ioCase.process();
+        }
+
+        for (int r = 0; r < inOptions.mNumRuns; ++r)
+        {
+            const Stamp start = now();
+            for (int j = 0; j < numBlocks; ++j)
+            {
+                ioCase.process();
+            }
+            const Stamp end = now();
+
+            ioTimings.mSeconds.add(juce::Time::highResolutionTicksToSeconds(end.mTicks - start.mTicks));
+            ioTimings.mCycles.add(double(end.mCycles - start.mCycles));
+        }
+        ioTimings.mNumSamples = double(numBlocks) * numChannels * blockSize;
+    }
+
+    // -------------------------------------------------------------------------
+
+    juce::var Suite::toJSON(const juce::Array<Result>& inResults, const Options& inOptions)
+    {
+        juce::Array<juce::var> results;
+        for (int i = 0; i < inResults.size(); ++i)
+        {
+            juce::DynamicObject* result = new juce::DynamicObject;
+            result->setProperty("name", inResults[i].mName);
+            result->setProperty("channels", inResults[i].mNumChannels);
+            result->setProperty("blockSize", inResults[i].mBlockSize);
+            result->setProperty("nsPerSample", inResults[i].mNsPerSample);
+            result->setProperty("cyclesPerSample", inResults[i].mCyclesPerSample);
+            result->setProperty("spread", inResults[i].mSpread);
+            results.add(juce::var(result));
+        }
+
+        juce::DynamicObject* root = new juce::DynamicObject;
+        root->setProperty("cpu", juce::SystemStats::getCpuVendor() + " "
+                                 + juce::String(juce::SystemStats::getCpuSpeedInMegaherz()) + " MHz");
+        root->setProperty("samplerate", inOptions.mSamplerate);
+        root->setProperty("workers", inOptions.mWorkers != 0);
+        root->setProperty("results", results);
+        return juce::var(root);
+    }
+
+    /*!
+        The results of a case are contiguous, as run measures them.
+        Baselines written before spreads were recorded count as noiseless.
+    */
+    int Suite::compare(const juce::Array<Result>& inResults, const juce::var& inBaseline, double inTolerance)
+    {
+        juce::HashMap<juce::String, double> baseline;
+        juce::HashMap<juce::String, double> baselineSpreads;
+        if (const juce::Array<juce::var>* results = inBaseline["results"].getArray())
+        {
+            for (int i = 0; i < results->size(); ++i)
+            {
+                const juce::var& result = results->getReference(i);
+                const juce::String key  = getKey(result["name"], result["channels"], result["blockSize"]);
+                baseline.set(key, result["nsPerSample"]);
+                baselineSpreads.set(key, result.getProperty("spread", 0.));
+            }
+        }
+
+        juce::Array<CaseChange> cases;
+        juce::Array<double> ratios;
+        juce::Array<double> spreads;
+        std::printf("\n%-32s %8s %6s %12s %12s %8s\n", "case", "channels", "block", "baseline", "ns/sample", "change");
+        for (int i = 0; i < inResults.size(); ++i)
+        {
+            const Result& result    = inResults.getReference(i);
+            const juce::String key  = getKey(result.mName, result.mNumChannels, result.mBlockSize);
+            if (!baseline.contains(key))
+            {
+                std::printf("%-32s %8d %6d %12s %12.3f\n", result.mName.toRawUTF8(), result.mNumChannels,
+                            result.mBlockSize, "-", result.mNsPerSample);
+            }
+            else
+            {
+                const double ratio      = result.mNsPerSample / baseline[key];
+                const double spread     = baselineSpreads[key];
+                ratios.add(ratio);
+                spreads.add(std::sqrt(result.mSpread * result.mSpread + spread * spread));
+                std::printf("%-32s %8d %6d %12.3f %12.3f %+7.1f%%\n", result.mName.toRawUTF8(), result.mNumChannels,
+                            result.mBlockSize, baseline[key], result.mNsPerSample, 100. * (ratio - 1.));
+            }
+
+            const bool isCaseDone = i + 1 == inResults.size() || inResults.getReference(i + 1).mName != result.mName;
+            if (isCaseDone && ratios.size() > 0)
+            {
+                const CaseChange change = { result.mName, median(ratios) - 1.,
+                                            std::max(inTolerance, noiseSigmas * median(spreads)) };
+                cases.add(change);
+                ratios.clearQuick();
+                spreads.clearQuick();
+            }
+        }
+
+        int numRegressions = 0;
+        std::printf("\n%-32s %8s %10s\n", "case", "change", "tolerance");
+        for (int i = 0; i < cases.size(); ++i)
+        {
+            const CaseChange& change    = cases.getReference(i);
+            const bool isRegression     = change.mChange > change.mTolerance;
+            numRegressions             += isRegression ? 1 : 0;
+            std::printf("%-32s %+7.1f%% %9.1f%%%s\n", change.mName.toRawUTF8(), 100. * change.mChange,
+                        100. * change.mTolerance, isRegression ? " slower" : "");
+        }
+        return numRegressions;
+    }
+}
@@ -0,0 +1,113 @@
+/*!
+ * \file       bench_Suite.h
+ * Copyright   Eiosis 2014
+ */
+
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace plugin
+{
+    class WorkerPool;
+}
+
+namespace bench
+{
+    struct Options
+    {
+        juce::String mFilter;           //<! Only cases whose name contains it run, all of them when empty
+        double mSamplerate;             //<! Samplerate the cells are reset at
+        int mNumSweeps;                 //<! Passes over all the measurements
+        int mNumRuns;                   //<! Timed runs per measurement and sweep, their median being reported
+        int mRunLength;                 //<! Channel samples processed per timed run, at least
+        plugin::WorkerPool* mWorkers;   //<! Pool processState may split its work across, or null
+    };
+
+    /*!
+        One measurement: the cost of processing inBlockSize samples blocks over inNumChannels channels,
+        per channel sample. Cycles are those of the time stamp counter, which runs at the nominal frequency.
+    */
+    struct Result
+    {
+        juce::String mName;
+        int mNumChannels;
+        int mBlockSize;
+        double mNsPerSample;
+        double mCyclesPerSample;
+        double mSpread;                 //<! Standard deviation of the runs, robustly estimated, over their median
+    };
+
+    // -------------------------------------------------------------------------
+
+    /*!
+        A Case is one piece of processing to measure, with the state and buffers it needs.
+        prepare is called before each measurement, outside of the timed runs,
+        then process is called once per block.
+    */
+    class Case
+    {
+    public:
+        virtual ~Case() {}
+
+    public:
+        virtual juce::String getName() const = 0;
+        virtual void prepare(int inNumChannels, int inBlockSize, const Options& inOptions) = 0;
+        virtual void process() = 0;
+    };
+
+    // -------------------------------------------------------------------------
+
+    /*!
+        The Suite measures each of its Cases over all channel counts and block sizes,
+        and compares the results to a baseline, as written by toJSON.
+        Each measurement is a warm up run followed by Options::mNumRuns timed runs,
+        each of them long enough for the timer resolution and the per block overhead of the loop
+        not to matter. The measurements are repeated over Options::mNumSweeps passes, so that
+        the slow drifts of a busy machine spread over all of them rather than hit a few cases,
+        and the median of all their runs is reported with their spread. A comparison can then
+        tell a slower case from a noisy machine.
+    */
+    class Suite
+    {
+    public:
+        Suite();
+        ~Suite();
+
+    public:
+        void add(Case* inCase);
+
+    public:
+        static const juce::Array<int>& getNumChannels();
+        static const juce::Array<int>& getBlockSizes();
+
+    public:
+        /*!
+            Runs the measurements, printing them once all sweeps are done.
+        */
+        juce::Array<Result> run(const Options& inOptions);
+
+    public:
+        static juce::var toJSON(const juce::Array<Result>& inResults, const Options& inOptions);
+
+        /*!
+            Prints the change of each result relative to the matching one of inBaseline, then the change
+            of each case, the median of those of its results, and returns the number of cases slower
+            than their tolerance. That is inTolerance (a ratio, such as .1 for 10%) or, on noisier runs,
+            three times the median spread of the case results and of their baseline.
+            Results missing from the baseline are only reported.
+        */
+        static int compare(const juce::Array<Result>& inResults, const juce::var& inBaseline, double inTolerance);
+
+    private:
+        struct Timings;
+
+        void measure(Timings& ioTimings, const Options& inOptions) const;
+
+    private:
+        juce::OwnedArray<Case> mCases;
+
+    private:
+        JUCE_DECLARE_NON_COPYABLE(Suite);
+    };
+}
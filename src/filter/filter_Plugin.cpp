@@ -15,34 +15,33 @@ namespace filter
 
     // -------------------------------------------------------------------------
 
-    FilterParametersInfo::FilterParametersInfo()
+    static const parameters::LinearParameterTaper gGainTaper(-18.f, +18.f);
+    static const parameters::EnumeratedParameterTaper gFilterTypeTaper(FilterTypes::numFilters);
+    static const parameters::LogParameterTaper gFrequencyTaper(10.f, 24000.f, 1000.f, .5f);
+    static const parameters::LinearParameterTaper gQTaper(.1f, 7.f);
+
+    static const parameters::ValueSuffixDisplayDelegate gGainDisplay("dB", 1, true);
+    static const parameters::EnumeratedDisplayDelegate gFilterTypeDisplay(FilterTypes::sNames, FilterTypes::numFilters);
+    static const parameters::ValueSuffixDisplayDelegate gFrequencyDisplay("Hz", 2, false);
+    static const parameters::ValueSuffixDisplayDelegate gQDisplay("", 2, false);
+
+    static const parameters::ParameterInfo gParameterInfos[numParameters] =
     {
-        registerInfo(paramInGain, "Input Gain", 0.f,
-                     new parameters::LinearParameterTaper(-18.f, +18.f),
-                     new parameters::ValueSuffixDisplayDelegate("dB", 1, true),
-                     offsetof(FilterPorts, mInputGain), sizeof(dsp::Gain::Port));
-        registerInfo(paramFilterType, "Filter Type", FilterTypes::bell,
-                     new parameters::EnumeratedParameterTaper(FilterTypes::numFilters),
-                     new parameters::EnumeratedDisplayDelegate(FilterTypes::sNames,
-                                                               FilterTypes::numFilters),
-                     offsetof(FilterPorts, mIIR), sizeof(dsp::IIR::Port));
-        registerInfo(paramFrequency, "Frequency", 1000.f,
-                     new parameters::LogParameterTaper(10.f, 24000.f, 1000.f, .5f),
-                     new parameters::ValueSuffixDisplayDelegate("Hz", 2, false),
-                     offsetof(FilterPorts, mIIR), sizeof(dsp::IIR::Port));
-        registerInfo(paramQ, "Q", 1.f,
-                     new parameters::LinearParameterTaper(.1f, 7.f),
-                     new parameters::ValueSuffixDisplayDelegate("", 2, false),
-                     offsetof(FilterPorts, mIIR), sizeof(dsp::IIR::Port));
-        registerInfo(paramGain, "Gain", 0.f,
-                     new parameters::LinearParameterTaper(-18.f, +18.f),
-                     new parameters::ValueSuffixDisplayDelegate("dB", 1, true),
-                     offsetof(FilterPorts, mIIR), sizeof(dsp::IIR::Port));
-        registerInfo(paramOutGain, "Output Gain", 0.f,
-                     new parameters::LinearParameterTaper(-18.f, +18.f),
-                     new parameters::ValueSuffixDisplayDelegate("dB", 1, true),
-                     offsetof(FilterPorts, mOutputGain), sizeof(dsp::Gain::Port));
-    }
+        { paramInGain,     "Input Gain",  0.f,                      &gGainTaper,       &gGainDisplay,
+          offsetof(FilterPorts, mInputGain),    sizeof(dsp::Gain::Port) },
+        { paramFilterType, "Filter Type", float(FilterTypes::bell), &gFilterTypeTaper, &gFilterTypeDisplay,
+          offsetof(FilterPorts, mIIR),          sizeof(dsp::IIR::Port) },
+        { paramFrequency,  "Frequency",   1000.f,                   &gFrequencyTaper,  &gFrequencyDisplay,
+          offsetof(FilterPorts, mIIR),          sizeof(dsp::IIR::Port) },
+        { paramQ,          "Q",           1.f,                      &gQTaper,          &gQDisplay,
+          offsetof(FilterPorts, mIIR),          sizeof(dsp::IIR::Port) },
+        { paramGain,       "Gain",        0.f,                      &gGainTaper,       &gGainDisplay,
+          offsetof(FilterPorts, mIIR),          sizeof(dsp::IIR::Port) },
+        { paramOutGain,    "Output Gain", 0.f,                      &gGainTaper,       &gGainDisplay,
+          offsetof(FilterPorts, mOutputGain),   sizeof(dsp::Gain::Port) },
+    };
+
+    const parameters::ParametersInfo<numParameters> gParametersInfo(gParameterInfos);
 
     // -------------------------------------------------------------------------
 
@@ -81,7 +80,7 @@ namespace filter
     void FilterProcessor::mapInputGain(void* outPortData)
     {
         dsp::Gain::Port& gainPort = *reinterpret_cast<dsp::Gain::Port*>(outPortData);
-        gainPort.mTargetGain = dsp::dBToLinear(getParameterPlain(paramInGain));
+        gainPort.mTargetGain = dsp::dBToLinear(dsp::float64(getParameterPlain(paramInGain)));
     }
 
     void FilterProcessor::mapFilter(void* outPortData)
@@ -96,123 +95,126 @@ namespace filter
     void FilterProcessor::mapOutputGain(void* outPortData)
     {
         dsp::Gain::Port& gainPort = *reinterpret_cast<dsp::Gain::Port*>(outPortData);
-        gainPort.mTargetGain = dsp::dBToLinear(getParameterPlain(paramOutGain));
+        gainPort.mTargetGain = dsp::dBToLinear(dsp::float64(getParameterPlain(paramOutGain)));
     }
 
     // -------------------------------------------------------------------------
 
-    void FilterProcessor::internalMapBell(dsp::IIR::Port& outIIR, float inFrequency,
-                                          float inQ, float inGain)
+    void FilterProcessor::internalMapBell(dsp::IIR::Port& outIIR, dsp::float64 inFrequency,
+                                          dsp::float64 inQ, dsp::float64 inGain)
     {
-        const dsp::float32 samplerate = dsp::float32(getSampleRate());
+        const dsp::float64 samplerate = getProcessSamplerate();
 
         jassert(samplerate > 0. && inQ > 0.);
 
-        const dsp::float32 clippedFreq      = std::min(inFrequency, .5f * samplerate - 100.f);
-        const dsp::float32 a                = std::pow(10.f, inGain / 40.f);
-        const dsp::float32 w                = dsp::twoPi_32 * clippedFreq / samplerate;
-        const dsp::float32 alpha            = .5f * std::sin(w) / inQ;
-        const dsp::float32 c2               = -2.f * std::cos(w);
-        const dsp::float32 alphaTimesA      = alpha * a;
-        const dsp::float32 alpheOverA       = alpha / a;
-        const dsp::float32 ib0              = 1.f / (1.f + alpheOverA);
-
-        outIIR.mCoefficients[0]             = ib0 * (1.f + alphaTimesA);
+        const dsp::float64 clippedFreq      = std::min(inFrequency, .5 * samplerate - 100.);
+        const dsp::float64 a                = dsp::dBToLinear(.5 * inGain);
+        dsp::float64 sinW, cosW;
+        dsp::gSinCosTable.sinCos(clippedFreq / samplerate, sinW, cosW);
+        const dsp::float64 alpha            = .5 * sinW / inQ;
+        const dsp::float64 c2               = -2. * cosW;
+        const dsp::float64 alphaTimesA      = alpha * a;
+        const dsp::float64 alpheOverA       = alpha / a;
+        const dsp::float64 ib0              = 1. / (1. + alpheOverA);
+
+        outIIR.mCoefficients[0]             = ib0 * (1. + alphaTimesA);
         outIIR.mCoefficients[1]             = ib0 * c2;
-        outIIR.mCoefficients[2]             = ib0 * (1.f - alphaTimesA);
-        outIIR.mCoefficients[3]             = 1.f;
+        outIIR.mCoefficients[2]             = ib0 * (1. - alphaTimesA);
+        outIIR.mCoefficients[3]             = 1.;
         outIIR.mCoefficients[4]             = ib0 * c2;
-        outIIR.mCoefficients[5]             = ib0 * (1.f - alpheOverA);
+        outIIR.mCoefficients[5]             = ib0 * (1. - alpheOverA);
     }
 
-    void FilterProcessor::internalMapLS(dsp::IIR::Port& outIIR, float inFrequency,
-                                        float inQ, float inGain)
+    void FilterProcessor::internalMapLS(dsp::IIR::Port& outIIR, dsp::float64 inFrequency,
+                                        dsp::float64 inQ, dsp::float64 inGain)
     {
-        const dsp::float32 samplerate = dsp::float32(getSampleRate());
+        const dsp::float64 samplerate = getProcessSamplerate();
 
         jassert(samplerate > 0. && inQ > 0.);
 
-        const dsp::float32 clippedFreq      = std::min(inFrequency, .5f * samplerate - 100.f);
-        const dsp::float32 a                = std::pow(10.f, inGain / 40.f);
-        const dsp::float32 aMinus1          = a - 1.f;
-        const dsp::float32 aPlus1           = a + 1.f;
-        const dsp::float32 w                = dsp::twoPi_32 * clippedFreq / samplerate;
-        const dsp::float32 cosW             = std::cos(w);
-        const dsp::float32 beta             = std::sin(w) * std::sqrt(a) / inQ;
-        const dsp::float32 aMinus1TimesCosW = aMinus1 * cosW;
-        const dsp::float32 ib0              = 1.f / (aPlus1 + aMinus1TimesCosW + beta);
+        const dsp::float64 clippedFreq      = std::min(inFrequency, .5 * samplerate - 100.);
+        const dsp::float64 a                = dsp::dBToLinear(.5 * inGain);
+        const dsp::float64 aMinus1          = a - 1.;
+        const dsp::float64 aPlus1           = a + 1.;
+        dsp::float64 sinW, cosW;
+        dsp::gSinCosTable.sinCos(clippedFreq / samplerate, sinW, cosW);
+        const dsp::float64 beta             = sinW * std::sqrt(a) / inQ;
+        const dsp::float64 aMinus1TimesCosW = aMinus1 * cosW;
+        const dsp::float64 ib0              = 1. / (aPlus1 + aMinus1TimesCosW + beta);
 
         outIIR.mCoefficients[0]             = ib0 * (a * (aPlus1 - aMinus1TimesCosW + beta));
-        outIIR.mCoefficients[1]             = ib0 * (a * 2.f * (aMinus1 - aPlus1 * cosW));
+        outIIR.mCoefficients[1]             = ib0 * (a * 2. * (aMinus1 - aPlus1 * cosW));
         outIIR.mCoefficients[2]             = ib0 * (a * (aPlus1 - aMinus1TimesCosW - beta));
-        outIIR.mCoefficients[3]             = 1.f;
-        outIIR.mCoefficients[4]             = ib0 * (-2.f * (aMinus1 + aPlus1 * cosW));
+        outIIR.mCoefficients[3]             = 1.;
+        outIIR.mCoefficients[4]             = ib0 * (-2. * (aMinus1 + aPlus1 * cosW));
         outIIR.mCoefficients[5]             = ib0 * (aPlus1 + aMinus1TimesCosW - beta);
     }
 
-    void FilterProcessor::internalMapHS(dsp::IIR::Port& outIIR, float inFrequency,
-                                        float inQ, float inGain)
+    void FilterProcessor::internalMapHS(dsp::IIR::Port& outIIR, dsp::float64 inFrequency,
+                                        dsp::float64 inQ, dsp::float64 inGain)
     {
-        const dsp::float32 samplerate = dsp::float32(getSampleRate());
+        const dsp::float64 samplerate = getProcessSamplerate();
 
         jassert(samplerate > 0. && inQ > 0.);
 
-        const dsp::float32 clippedFreq      = std::min(inFrequency, .5f * samplerate - 100.f);
-        const dsp::float32 a                = std::pow(10.f, inGain / 40.f);
-        const dsp::float32 aMinus1          = a - 1.f;
-        const dsp::float32 aPlus1           = a + 1.f;
-        const dsp::float32 w                = dsp::twoPi_32 * clippedFreq / samplerate;
-        const dsp::float32 cosW             = std::cos(w);
-        const dsp::float32 beta             = std::sin(w) * std::sqrt(a) / inQ;
-        const dsp::float32 aMinus1TimesCosW = aMinus1 * cosW;
-        const dsp::float32 ib0              = 1.f / (aPlus1 - aMinus1TimesCosW + beta);
+        const dsp::float64 clippedFreq      = std::min(inFrequency, .5 * samplerate - 100.);
+        const dsp::float64 a                = dsp::dBToLinear(.5 * inGain);
+        const dsp::float64 aMinus1          = a - 1.;
+        const dsp::float64 aPlus1           = a + 1.;
+        dsp::float64 sinW, cosW;
+        dsp::gSinCosTable.sinCos(clippedFreq / samplerate, sinW, cosW);
+        const dsp::float64 beta             = sinW * std::sqrt(a) / inQ;
+        const dsp::float64 aMinus1TimesCosW = aMinus1 * cosW;
+        const dsp::float64 ib0              = 1. / (aPlus1 - aMinus1TimesCosW + beta);
 
         outIIR.mCoefficients[0]             = ib0 * (a * (aPlus1 + aMinus1TimesCosW + beta));
-        outIIR.mCoefficients[1]             = ib0 * (a * -2.f * (aMinus1 + aPlus1 * cosW));
+        outIIR.mCoefficients[1]             = ib0 * (a * -2. * (aMinus1 + aPlus1 * cosW));
         outIIR.mCoefficients[2]             = ib0 * (a * (aPlus1 + aMinus1TimesCosW - beta));
-        outIIR.mCoefficients[3]             = 1.f;
-        outIIR.mCoefficients[4]             = ib0 * (2.f * (aMinus1 - aPlus1 * cosW));
+        outIIR.mCoefficients[3]             = 1.;
+        outIIR.mCoefficients[4]             = ib0 * (2. * (aMinus1 - aPlus1 * cosW));
         outIIR.mCoefficients[5]             = ib0 * (aPlus1 - aMinus1TimesCosW - beta);
     }
 
-    void FilterProcessor::internalMapHP(dsp::IIR::Port& outIIR, float inFrequency,
-                                        float inQ, float)
+    void FilterProcessor::internalMapHP(dsp::IIR::Port& outIIR, dsp::float64 inFrequency,
+                                        dsp::float64 inQ, dsp::float64)
     {
-        const dsp::float32 samplerate = dsp::float32(getSampleRate());
+        const dsp::float64 samplerate = getProcessSamplerate();
 
         jassert(samplerate > 0. && inQ > 0.);
 
-        const dsp::float32 clippedFreq      = std::min(inFrequency, .5f * samplerate - 100.f);
-        const dsp::float32 w0               = dsp::twoPi_32 * clippedFreq / samplerate;
-        const dsp::float32 alpha            = std::sin(w0) / (2.f * inQ);
-        const dsp::float32 ib0              = 1.f / (1.f + alpha);
+        const dsp::float64 clippedFreq      = std::min(inFrequency, .5 * samplerate - 100.);
+        dsp::float64 sinW0, cosW0;
+        dsp::gSinCosTable.sinCos(clippedFreq / samplerate, sinW0, cosW0);
+        const dsp::float64 alpha            = sinW0 / (2. * inQ);
+        const dsp::float64 ib0              = 1. / (1. + alpha);
 
-        outIIR.mCoefficients[0]             = ib0 * (.5f * (1.f + std::cos(w0)));
-        outIIR.mCoefficients[1]             = ib0 * (-(1.f + std::cos(w0)));
-        outIIR.mCoefficients[2]             = ib0 * (.5f * (1.f + std::cos(w0)));
+        outIIR.mCoefficients[0]             = ib0 * (.5 * (1. + cosW0));
+        outIIR.mCoefficients[1]             = ib0 * (-(1. + cosW0));
+        outIIR.mCoefficients[2]             = ib0 * (.5 * (1. + cosW0));
         outIIR.mCoefficients[3]             = 1.;
-        outIIR.mCoefficients[4]             = ib0 * ( -2.f * std::cos(w0));
-        outIIR.mCoefficients[5]             = ib0 * (1.f - alpha);
+        outIIR.mCoefficients[4]             = ib0 * ( -2. * cosW0);
+        outIIR.mCoefficients[5]             = ib0 * (1. - alpha);
     }
 
-    void FilterProcessor::internalMapLP(dsp::IIR::Port& outIIR, float inFrequency,
-                                        float inQ, float)
+    void FilterProcessor::internalMapLP(dsp::IIR::Port& outIIR, dsp::float64 inFrequency,
+                                        dsp::float64 inQ, dsp::float64)
     {
-        const dsp::float32 samplerate = dsp::float32(getSampleRate());
+        const dsp::float64 samplerate = getProcessSamplerate();
 
         jassert(samplerate > 0. && inQ > 0.);
 
-        const dsp::float32 clippedFreq      = std::min(inFrequency, .5f * samplerate - 100.f);
-        const dsp::float32 w0               = dsp::twoPi_32 * clippedFreq / samplerate;
-        const dsp::float32 alpha            = std::sin(w0) / (2.f * inQ);
-        const dsp::float32 ib0              = 1.f / (1.f + alpha);
-
-        outIIR.mCoefficients[0]             = ib0 * (.5f * (1.f - std::cos(w0)));
-        outIIR.mCoefficients[1]             = ib0 * ((1.f - std::cos(w0)));
-        outIIR.mCoefficients[2]             = ib0 * (.5f * (1.f - std::cos(w0)));
-        outIIR.mCoefficients[3]             = 1.f;
-        outIIR.mCoefficients[4]             = ib0 * (-2.f * std::cos(w0));
-        outIIR.mCoefficients[5]             = ib0 * (1.f - alpha);
+        const dsp::float64 clippedFreq      = std::min(inFrequency, .5 * samplerate - 100.);
+        dsp::float64 sinW0, cosW0;
+        dsp::gSinCosTable.sinCos(clippedFreq / samplerate, sinW0, cosW0);
+        const dsp::float64 alpha            = sinW0 / (2. * inQ);
+        const dsp::float64 ib0              = 1. / (1. + alpha);
+
+        outIIR.mCoefficients[0]             = ib0 * (.5 * (1. - cosW0));
+        outIIR.mCoefficients[1]             = ib0 * ((1. - cosW0));
+        outIIR.mCoefficients[2]             = ib0 * (.5 * (1. - cosW0));
+        outIIR.mCoefficients[3]             = 1.;
+        outIIR.mCoefficients[4]             = ib0 * (-2. * cosW0);
+        outIIR.mCoefficients[5]             = ib0 * (1. - alpha);
     }
 }
 
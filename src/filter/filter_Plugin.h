@@ -41,12 +41,7 @@ namespace filter
 
     // -------------------------------------------------------------------------
 
-    struct FilterParametersInfo : parameters::ParametersInfo<numParameters>
-    {
-        FilterParametersInfo();
-    };
-
-    static const FilterParametersInfo gParametersInfo;
+    extern const parameters::ParametersInfo<numParameters> gParametersInfo;
 
     // -------------------------------------------------------------------------
 
@@ -66,19 +61,19 @@ namespace filter
         void mapOutputGain(void* outPortData);
 
     private:
-        void internalMapBell(dsp::IIR::Port& outIIR, float inFrequency,
-                             float inQ, float inGain);
-        void internalMapLS(dsp::IIR::Port& outIIR, float inFrequency,
-                           float inQ, float inGain);
-        void internalMapHS(dsp::IIR::Port& outIIR, float inFrequency,
-                          float inQ, float inGain);
-        void internalMapHP(dsp::IIR::Port& outIIR, float inFrequency,
-                          float inQ, float inGain);
-        void internalMapLP(dsp::IIR::Port& outIIR, float inFrequency,
-                          float inQ, float inGain);
+        void internalMapBell(dsp::IIR::Port& outIIR, dsp::float64 inFrequency,
+                             dsp::float64 inQ, dsp::float64 inGain);
+        void internalMapLS(dsp::IIR::Port& outIIR, dsp::float64 inFrequency,
+                           dsp::float64 inQ, dsp::float64 inGain);
+        void internalMapHS(dsp::IIR::Port& outIIR, dsp::float64 inFrequency,
+                          dsp::float64 inQ, dsp::float64 inGain);
+        void internalMapHP(dsp::IIR::Port& outIIR, dsp::float64 inFrequency,
+                          dsp::float64 inQ, dsp::float64 inGain);
+        void internalMapLP(dsp::IIR::Port& outIIR, dsp::float64 inFrequency,
+                          dsp::float64 inQ, dsp::float64 inGain);
 
     private:
-        typedef void (FilterProcessor::*Mapper)(dsp::IIR::Port&, float, float, float);
+        typedef void (FilterProcessor::*Mapper)(dsp::IIR::Port&, dsp::float64, dsp::float64, dsp::float64);
         Mapper mFilterMappers[FilterTypes::numFilters];
 
     private:
@@ -17,41 +17,53 @@ namespace filter
         dsp::Gain::Port mOutputGain;
     };
 
+    typedef dsp::IIRCascade<1> FilterChain;
+
+    enum { numChannelGroups = plugin::gNumMaxChannels / FilterChain::numLanes };
+
+    /*!
+        Channels are processed by groups of FilterChain::numLanes, each group having its own chain State.
+    */
+    template<typename SampleType>
     struct FilterState : plugin::StateBase
     {
-        dsp::Gain::State mInputGain[plugin::gNumMaxChannels];
-        dsp::IIR::State mIIR[plugin::gNumMaxChannels];
-        dsp::Gain::State mOutputGain[plugin::gNumMaxChannels];
+        FilterChain::State<SampleType> mChains[numChannelGroups];
     };
-}
 
-// -----------------------------------------------------------------------------
+    // -------------------------------------------------------------------------
 
-template<>
-inline void resetState(filter::FilterState& ioState)
-{
-    for (unsigned int i = 0; i < plugin::gNumMaxChannels; ++i)
+    template<typename SampleType>
+    inline void resetState(FilterState<SampleType>& ioState)
     {
-        dsp::Gain::reset(ioState.mInputGain[i]);
-        dsp::IIR::reset(ioState.mIIR[i]);
-        dsp::Gain::reset(ioState.mOutputGain[i]);
+        static_jassert(plugin::gNumMaxChannels % FilterChain::numLanes == 0);
+
+        for (int g = 0; g < numChannelGroups; ++g)
+        {
+            FilterChain::reset(ioState.mChains[g], ioState.mSamplerate);
+        }
     }
-}
 
-template<>
-inline void processState(const dsp::ProcessType*const* inInputChannels, int inNumInputChannels,
-                         dsp::ProcessType*const* inOutputChannels, int inNumOutputChannels,
-                         int inNumSamples, const filter::FilterPorts& inPorts,
-                         filter::FilterState& ioState)
-{
-    for (int i = 0; i < inNumInputChannels; ++i)
+    template<typename SampleType>
+    inline void processState(const SampleType*const* inInputChannels, int inNumInputChannels,
+                             SampleType*const* inOutputChannels, int inNumOutputChannels,
+                             int inNumSamples, const FilterPorts& inPorts,
+                             FilterState<SampleType>& ioState)
     {
-        dsp::Gain::process(inInputChannels[i], inOutputChannels[i], inNumSamples,
-                           inPorts.mInputGain, ioState.mInputGain[i]);
-        dsp::IIR::process(inOutputChannels[i], inOutputChannels[i], inNumSamples,
-                          inPorts.mIIR, ioState.mIIR[i]);
-        dsp::Gain::process(inOutputChannels[i], inOutputChannels[i], inNumSamples,
-                           inPorts.mOutputGain, ioState.mOutputGain[i]);
+        jassert(inNumInputChannels <= int(plugin::gNumMaxChannels));
+
+        const dsp::IIR::Port* sections[1] = { &inPorts.mIIR };
+
+        plugin::ChannelGroups<FilterChain, SampleType>::process(inInputChannels, inOutputChannels,
+                                                                inNumInputChannels, inNumSamples,
+                                                                inPorts.mInputGain, sections, inPorts.mOutputGain,
+                                                                ioState.mChains, ioState.mWorkers);
+        (void)inNumOutputChannels;
+    }
+
+    inline double tailLengthSeconds(const FilterPorts& inPorts, double inSamplerate)
+    {
+        const dsp::IIR::Port* sections[1] = { &inPorts.mIIR };
+
+        return FilterChain::tailLength(sections, inSamplerate);
     }
-    (void)inNumOutputChannels;
 }
@@ -6,55 +6,196 @@
 #pragma once
 
 #include "framework/framework_DSP.h"
+#include "framework/framework_SIMD.h"
 
 namespace dsp
 {
+    /*
+        Cells are templated on their SampleType (float32 or float64) through their State and process.
+        Ports do not depend on the sample type: they are mapped in float64 once,
+        and are shared by both processing precisions.
+    */
+
+    // -------------------------------------------------------------------------
+
+    /*!
+        Silence tells whether audio, or a cell state, is below threshold (-140 dB),
+        so that processState can skip cells or channels while their input stays silent.
+    */
+    struct Silence
+    {
+        enum { chunkSize = 16 };
+
+        static inline float64 threshold()
+        {
+            return 1e-7;
+        }
+
+        template<typename SampleType>
+        static inline bool isSilent(SampleType inValue)
+        {
+            return std::abs(inValue) < SampleType(threshold());
+        }
+        /*!
+            Looks at the samples a chunk at a time,
+            so that the common non silent case only goes through the first chunk.
+        */
+        template<typename SampleType>
+        static inline bool isSilent(const SampleType* inSrc, int inNumSamples)
+        {
+            const SampleType limit = SampleType(threshold());
+            for (int j = 0; j < inNumSamples; j += chunkSize)
+            {
+                const int end = std::min(j + int(chunkSize), inNumSamples);
+                SampleType peak = SampleType(0);
+                for (int i = j; i < end; ++i)
+                {
+                    peak = std::max(peak, std::abs(inSrc[i]));
+                }
+                if (peak >= limit)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+        template<typename SampleType>
+        static inline bool isSilent(const SampleType*const* inSrc, int inNumChannels, int inNumSamples)
+        {
+            for (int c = 0; c < inNumChannels; ++c)
+            {
+                if (!isSilent(inSrc[c], inNumSamples))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        template<typename SampleType>
+        static inline void clear(SampleType* outDest, int inNumSamples)
+        {
+            std::fill(outDest, outDest + inNumSamples, SampleType(0));
+        }
+        template<typename SampleType>
+        static inline void clear(SampleType*const* outDest, int inNumChannels, int inNumSamples)
+        {
+            for (int c = 0; c < inNumChannels; ++c)
+            {
+                clear(outDest[c], inNumSamples);
+            }
+        }
+    };
+
+    // -------------------------------------------------------------------------
+
+    /*!
+        Gain ramps to its target exponentially, with a time constant of rampTime seconds
+        whatever the samplerate. The ramp is computed in closed form a vector of samples at a time,
+        the distance to the target being scaled by the per sample decay powers.
+        The ramp is computed in float64 and each gain rounded once, as float32 steps of decay^4
+        drift from it, and a float32 distance rounds the same way over a whole vector.
+        A settled gain is applied as a constant, and a settled unity gain only copies
+        (or does nothing at all when processing in place).
+    */
     struct Gain
     {
         struct Port
         {
-            ProcessType mTargetGain;
+            float64 mTargetGain;
         };
 
+        template<typename SampleType>
         struct State
         {
-            ProcessType mCurrentGain;
+            SampleType mCurrentGain;
+            SampleType mDecay;
         };
 
-        static inline void reset(State& ioState)
+        static inline float64 rampTime()
         {
-            ioState.mCurrentGain = 0.f;
+            return .01;
         }
-        static inline void process(const ProcessType* inSrc, ProcessType* outDest,
-                                   int inNumSamples, const Port& inPort, State& ioState)
+        static inline float64 decay(double inSamplerate)
         {
-            ProcessType gain            = ioState.mCurrentGain;
-            const ProcessType target    = inPort.mTargetGain;
-            const ProcessType epsilon   = 1e-9f;
-            const ProcessType delta     = target - gain;
-            const ProcessType deltaAbs  = std::abs(delta);
+            return inSamplerate > 0. ? std::exp(-1. / (rampTime() * inSamplerate)) : 0.;
+        }
 
-            const ProcessType* src      = inSrc;
-            ProcessType* dest           = outDest;
+        template<typename SampleType>
+        static inline void reset(State<SampleType>& ioState, double inSamplerate)
+        {
+            ioState.mCurrentGain    = SampleType(0);
+            ioState.mDecay          = SampleType(decay(inSamplerate));
+        }
+        /*!
+            Moves the ramp inNumSamples forward without processing,
+            for blocks whose input is silent.
+        */
+        template<typename SampleType>
+        static inline void skip(int inNumSamples, const Port& inPort, State<SampleType>& ioState)
+        {
+            const SampleType target = SampleType(inPort.mTargetGain);
+            const SampleType delta  = (ioState.mCurrentGain - target) * std::pow(ioState.mDecay, SampleType(inNumSamples));
+            ioState.mCurrentGain    = std::abs(delta) < SampleType(1e-9) ? target : target + delta;
+        }
+        template<typename SampleType>
+        static inline void process(const SampleType* inSrc, SampleType* outDest,
+                                   int inNumSamples, const Port& inPort, State<SampleType>& ioState)
+        {
+            typedef typename simd::Vector<SampleType>::Type Vector;
+
+            const SampleType target     = SampleType(inPort.mTargetGain);
+            const SampleType epsilon    = SampleType(1e-9);
+            SampleType delta            = ioState.mCurrentGain - target;
 
-            if (deltaAbs < epsilon)
+            const int numLanes          = simd::numLanes;
+            int j                       = 0;
+
+            if (std::abs(delta) < epsilon)
             {
-                gain = target;
-                for (int i = 0; i < inNumSamples; ++i)
+                ioState.mCurrentGain = target;
+                if (target == SampleType(1))
+                {
+                    if (inSrc != outDest)
+                    {
+                        std::copy(inSrc, inSrc + inNumSamples, outDest);
+                    }
+                    return;
+                }
+
+                const Vector gain = simd::set(target);
+                for (; j + numLanes <= inNumSamples; j += numLanes)
                 {
-                    *dest++ = *src++ * gain;
+                    simd::store(outDest + j, simd::mul(simd::load(inSrc + j), gain));
                 }
+                for (; j < inNumSamples; ++j)
+                {
+                    outDest[j] = inSrc[j] * target;
+                }
+                return;
             }
-            else
+
+            const float64 decay         = float64(ioState.mDecay);
+            const float64 powers[]      = { decay, decay * decay, decay * decay * decay,
+                                            decay * decay * decay * decay };
+            float64 distance            = float64(ioState.mCurrentGain) - float64(target);
+
+            for (; j + numLanes <= inNumSamples; j += numLanes)
             {
-                const ProcessType slew = .0025f;
-                for (int i = 0; i < inNumSamples; ++i)
+                SampleType gains[numLanes];
+                for (int n = 0; n < numLanes; ++n)
                 {
-                    gain += slew * (target - gain);
-                    *dest++ = *src++ * gain;
+                    gains[n] = SampleType(target + distance * powers[n]);
                 }
+                simd::store(outDest + j, simd::mul(simd::load(inSrc + j), simd::load(gains)));
+                distance *= powers[numLanes - 1];
+            }
+            for (; j < inNumSamples; ++j)
+            {
+                distance *= decay;
+                outDest[j] = inSrc[j] * SampleType(target + distance);
             }
-            ioState.mCurrentGain = gain;
+            ioState.mCurrentGain = SampleType(target + distance);
         }
     };
 
@@ -64,48 +205,802 @@ namespace dsp
     {
         struct Port
         {
-            float32 mCoefficients[6];
+            float64 mCoefficients[6];
         };
 
+        template<typename SampleType>
         struct State
         {
-            float32 mX;
-            float32 mY;
+            SampleType mX;
+            SampleType mY;
         };
 
-        static inline void reset(State& ioState)
+        template<typename SampleType>
+        static inline void reset(State<SampleType>& ioState)
         {
-            ioState.mX = 0.f;
-            ioState.mY = 0.f;
+            ioState.mX = SampleType(0);
+            ioState.mY = SampleType(0);
         }
-        static inline void process(const ProcessType* inSrc, ProcessType* outDest,
-                                   int inNumSamples, const Port& inPort, State& ioState)
+        template<typename SampleType>
+        static inline void process(const SampleType* inSrc, SampleType* outDest,
+                                   int inNumSamples, const Port& inPort, State<SampleType>& ioState)
         {
-            const float32 a0 = inPort.mCoefficients[0];
-            const float32 a1 = inPort.mCoefficients[1];
-            const float32 a2 = inPort.mCoefficients[2];
+            const SampleType a0 = SampleType(inPort.mCoefficients[0]);
+            const SampleType a1 = SampleType(inPort.mCoefficients[1]);
+            const SampleType a2 = SampleType(inPort.mCoefficients[2]);
 
-            const float32 b1 = inPort.mCoefficients[4];
-            const float32 b2 = inPort.mCoefficients[5];
+            const SampleType b1 = SampleType(inPort.mCoefficients[4]);
+            const SampleType b2 = SampleType(inPort.mCoefficients[5]);
 
-            const ProcessType* src  = inSrc;
-            ProcessType* dest       = outDest;
+            const SampleType* src   = inSrc;
+            SampleType* dest        = outDest;
 
-            float32 x = ioState.mX;
-            float32 y = ioState.mY;
+            SampleType x = ioState.mX;
+            SampleType y = ioState.mY;
 
             for (int j = 0; j < inNumSamples; ++j)
             {
-                const ProcessType in = *src++;
-                const ProcessType out = a0 * in + x;
+                const SampleType in = *src++;
+                const SampleType out = a0 * in + x;
                 *dest++ = out;
 
                 x = a1 * in - b1 * out + y;
                 y = a2 * in - b2 * out;
             }
 
-            ioState.mX = dsp_denormalize_32(x);
-            ioState.mY = dsp_denormalize_32(y);
+            ioState.mX = x;
+            ioState.mY = y;
+        }
+
+        template<typename SampleType>
+        static inline bool isIdle(const State<SampleType>& inState)
+        {
+            return Silence::isSilent(inState.mX) && Silence::isSilent(inState.mY);
+        }
+
+        /*!
+            Returns the time the impulse response takes to decay below Silence::threshold,
+            from the largest pole radius of the Port, or maxTailLength for unstable or
+            marginally stable Ports.
+        */
+        static inline float64 maxTailLength()
+        {
+            return 60.;
+        }
+        static inline float64 tailLength(const Port& inPort, double inSamplerate)
+        {
+            const float64 b1            = inPort.mCoefficients[4];
+            const float64 b2            = inPort.mCoefficients[5];
+            const float64 discriminant  = b1 * b1 - 4. * b2;
+
+            // Poles of z^2 + b1.z + b2, complex conjugates share the radius sqrt(b2)
+            const float64 radius = discriminant < 0. ? std::sqrt(b2)
+                                                     : .5 * (std::abs(b1) + std::sqrt(discriminant));
+            if (radius >= 1. || inSamplerate <= 0.)
+            {
+                return maxTailLength();
+            }
+
+            // The 2 samples of the zeros, then the poles decay
+            const float64 numSamples = radius > 0. ? 2. + std::log(Silence::threshold()) / std::log(radius) : 2.;
+            return std::min(numSamples / inSamplerate, maxTailLength());
+        }
+    };
+
+    // -------------------------------------------------------------------------
+
+    /*!
+        Lanes binds up to simd::numLanes channel buffers to the lanes of a vector.
+        Samples are moved numLanes at a time per channel and transposed, so that
+        each vector holds one sample frame. Unused lanes read zeros and write to
+        a scratch area, with a null stride.
+    */
+    template<typename SampleType>
+    class Lanes
+    {
+    public:
+        enum { numLanes = simd::numLanes };
+
+        typedef typename simd::Vector<SampleType>::Type Vector;
+
+    public:
+        Lanes(const SampleType*const* inSrc, SampleType*const* outDest, int inNumChannels)
+        {
+            for (int c = 0; c < numLanes; ++c)
+            {
+                const bool used = c < inNumChannels;
+                mScratchIn[c]   = SampleType(0);
+                mSrc[c]         = used ? inSrc[c] : mScratchIn;
+                mDest[c]        = used ? outDest[c] : mScratchOut;
+                mStride[c]      = used ? 1 : 0;
+            }
+        }
+
+    public:
+        inline void loadFrames(int inIndex, Vector& outF0, Vector& outF1,
+                               Vector& outF2, Vector& outF3) const
+        {
+            outF0 = simd::load(mSrc[0] + inIndex * mStride[0]);
+            outF1 = simd::load(mSrc[1] + inIndex * mStride[1]);
+            outF2 = simd::load(mSrc[2] + inIndex * mStride[2]);
+            outF3 = simd::load(mSrc[3] + inIndex * mStride[3]);
+            simd::transpose(outF0, outF1, outF2, outF3);
+        }
+        inline void storeFrames(int inIndex, Vector inF0, Vector inF1,
+                                Vector inF2, Vector inF3)
+        {
+            simd::transpose(inF0, inF1, inF2, inF3);
+            simd::store(mDest[0] + inIndex * mStride[0], inF0);
+            simd::store(mDest[1] + inIndex * mStride[1], inF1);
+            simd::store(mDest[2] + inIndex * mStride[2], inF2);
+            simd::store(mDest[3] + inIndex * mStride[3], inF3);
+        }
+
+    public:
+        inline Vector loadFrame(int inIndex) const
+        {
+            SampleType frame[numLanes];
+            for (int c = 0; c < numLanes; ++c)
+            {
+                frame[c] = mSrc[c][inIndex * mStride[c]];
+            }
+            return simd::load(frame);
+        }
+        inline void storeFrame(int inIndex, Vector inFrame)
+        {
+            SampleType frame[numLanes];
+            simd::store(frame, inFrame);
+            for (int c = 0; c < numLanes; ++c)
+            {
+                mDest[c][inIndex * mStride[c]] = frame[c];
+            }
+        }
+
+    private:
+        const SampleType* mSrc[numLanes];
+        SampleType* mDest[numLanes];
+        int mStride[numLanes];
+        SampleType mScratchIn[numLanes];
+        SampleType mScratchOut[numLanes];
+    };
+
+    // -------------------------------------------------------------------------
+
+    /*!
+        MultiIIR runs the IIR biquad on up to simd::numLanes channels at once.
+        All channels share the same Port, each channel has its own lane in the State,
+        so that L/R (or any channel group) are processed in lockstep in one register.
+    */
+    struct MultiIIR
+    {
+        enum { numLanes = simd::numLanes };
+
+        typedef IIR::Port Port;
+
+        template<typename SampleType>
+        struct State
+        {
+            SampleType mX[numLanes];
+            SampleType mY[numLanes];
+        };
+
+        template<typename SampleType>
+        static inline void reset(State<SampleType>& ioState)
+        {
+            for (int i = 0; i < numLanes; ++i)
+            {
+                ioState.mX[i] = SampleType(0);
+                ioState.mY[i] = SampleType(0);
+            }
+        }
+        template<typename SampleType>
+        static inline void process(const SampleType*const* inSrc, SampleType*const* outDest,
+                                   int inNumChannels, int inNumSamples,
+                                   const Port& inPort, State<SampleType>& ioState)
+        {
+            typedef typename simd::Vector<SampleType>::Type Vector;
+
+            const Vector a0 = simd::set(SampleType(inPort.mCoefficients[0]));
+            const Vector a1 = simd::set(SampleType(inPort.mCoefficients[1]));
+            const Vector a2 = simd::set(SampleType(inPort.mCoefficients[2]));
+
+            const Vector b1 = simd::set(SampleType(inPort.mCoefficients[4]));
+            const Vector b2 = simd::set(SampleType(inPort.mCoefficients[5]));
+
+            Lanes<SampleType> lanes(inSrc, outDest, inNumChannels);
+
+            Vector x = simd::load(ioState.mX);
+            Vector y = simd::load(ioState.mY);
+
+            int j = 0;
+            for (; j + numLanes <= inNumSamples; j += numLanes)
+            {
+                Vector f0, f1, f2, f3;
+                lanes.loadFrames(j, f0, f1, f2, f3);
+
+                f0 = tick(f0, a0, a1, a2, b1, b2, x, y);
+                f1 = tick(f1, a0, a1, a2, b1, b2, x, y);
+                f2 = tick(f2, a0, a1, a2, b1, b2, x, y);
+                f3 = tick(f3, a0, a1, a2, b1, b2, x, y);
+
+                lanes.storeFrames(j, f0, f1, f2, f3);
+            }
+
+            for (; j < inNumSamples; ++j)
+            {
+                lanes.storeFrame(j, tick(lanes.loadFrame(j), a0, a1, a2, b1, b2, x, y));
+            }
+
+            storeState(x, y, ioState);
+        }
+
+        template<typename Vector>
+        static inline Vector tick(Vector inSample,
+                                  Vector inA0, Vector inA1, Vector inA2,
+                                  Vector inB1, Vector inB2,
+                                  Vector& ioX, Vector& ioY)
+        {
+            const Vector out = simd::add(simd::mul(inA0, inSample), ioX);
+            ioX = simd::add(simd::sub(simd::mul(inA1, inSample), simd::mul(inB1, out)), ioY);
+            ioY = simd::sub(simd::mul(inA2, inSample), simd::mul(inB2, out));
+            return out;
+        }
+
+        template<typename Vector, typename SampleType>
+        static inline void storeState(Vector inX, Vector inY, State<SampleType>& outState)
+        {
+            simd::store(outState.mX, inX);
+            simd::store(outState.mY, inY);
+        }
+    };
+
+    // -------------------------------------------------------------------------
+
+    /*!
+        BlockIIR is a time-parallel formulation of the IIR biquad for a single channel.
+        The biquad is written as a state-space system (the state being the IIR mX/mY memories),
+        from which a Kernel gives simd::numLanes consecutive outputs and the next state
+        as a linear combination of the inputs and the current state.
+        Only the state update is sequential, once per vector instead of once per sample.
+        The Kernel is computed in float64 from the Port, on a state that does not cancel near z = 1.
+        As building a Kernel has a cost, the time-parallel path is only worth it from
+        minNumSamples samples on. In float32 the Kernel products round about 20 dB above
+        the IIR cell, so float32 always runs the IIR cell: the output then does not depend
+        on the channel count nor on the host block size. BlockIIR runs on the IIR State.
+    */
+    struct BlockIIR
+    {
+        enum { blockSize = simd::numLanes, minNumSamples = 64 };
+
+        typedef IIR::Port Port;
+
+        /*!
+            For each of the inputs in[0..3], x and x + y (in that order),
+            its contribution to the 4 outputs, and to the next x and y (lanes 0 and 1).
+        */
+        template<typename SampleType>
+        struct Kernel
+        {
+            typedef typename simd::Vector<SampleType>::Type Vector;
+
+            Vector mOut[blockSize + 2];
+            Vector mNext[blockSize + 2];
+        };
+
+        template<typename SampleType>
+        static inline void reset(IIR::State<SampleType>& ioState)
+        {
+            IIR::reset(ioState);
+        }
+        template<typename SampleType>
+        static inline void process(const SampleType* inSrc, SampleType* outDest,
+                                   int inNumSamples, const Port& inPort, IIR::State<SampleType>& ioState)
+        {
+            typedef typename simd::Vector<SampleType>::Type Vector;
+
+            if (!isEnabled(inNumSamples, SampleType()))
+            {
+                IIR::process(inSrc, outDest, inNumSamples, inPort, ioState);
+                return;
+            }
+
+            Kernel<SampleType> kernel;
+            makeKernel(inPort, kernel);
+            Vector s = loadState(ioState);
+
+            const int numVectorSamples = inNumSamples - inNumSamples % blockSize;
+            for (int j = 0; j < numVectorSamples; j += blockSize)
+            {
+                simd::store(outDest + j, step(simd::load(inSrc + j), kernel, s));
+            }
+
+            storeState(s, ioState);
+            IIR::process(inSrc + numVectorSamples, outDest + numVectorSamples,
+                         inNumSamples - numVectorSamples, inPort, ioState);
+        }
+
+        /*!
+            Whether inNumSamples samples run in the time-parallel form.
+        */
+        static inline bool isEnabled(int inNumSamples, float64)
+        {
+            return inNumSamples >= minNumSamples;
+        }
+        static inline bool isEnabled(int, float32)
+        {
+            return false;
+        }
+
+        /*!
+            The kernels run on the state x, x + y: near z = 1, where the low poles are,
+            y is close to -x, and the outputs would otherwise cancel large products of both.
+        */
+        template<typename SampleType>
+        static inline typename Kernel<SampleType>::Vector loadState(const IIR::State<SampleType>& inState)
+        {
+            const SampleType state[blockSize] = { inState.mX, inState.mX + inState.mY, SampleType(0), SampleType(0) };
+            return simd::load(state);
+        }
+
+        template<typename SampleType>
+        static inline void storeState(typename Kernel<SampleType>::Vector inState, IIR::State<SampleType>& outState)
+        {
+            SampleType state[blockSize];
+            simd::store(state, inState);
+            outState.mX = state[0];
+            outState.mY = state[1] - state[0];
+        }
+
+        template<typename SampleType>
+        static inline typename Kernel<SampleType>::Vector step(typename Kernel<SampleType>::Vector inSamples,
+                                                               const Kernel<SampleType>& inKernel,
+                                                               typename Kernel<SampleType>::Vector& ioState)
+        {
+            typedef typename Kernel<SampleType>::Vector Vector;
+
+            const Vector in0    = simd::broadcast<0>(inSamples);
+            const Vector in1    = simd::broadcast<1>(inSamples);
+            const Vector in2    = simd::broadcast<2>(inSamples);
+            const Vector in3    = simd::broadcast<3>(inSamples);
+            const Vector x      = simd::broadcast<0>(ioState);
+            const Vector y      = simd::broadcast<1>(ioState);
+
+            const Vector* k     = inKernel.mOut;
+            const Vector out    = simd::add(simd::add(simd::add(simd::mul(k[0], in0), simd::mul(k[1], in1)),
+                                                      simd::add(simd::mul(k[2], in2), simd::mul(k[3], in3))),
+                                            simd::add(simd::mul(k[4], x), simd::mul(k[5], y)));
+            k = inKernel.mNext;
+            ioState             = simd::add(simd::add(simd::add(simd::mul(k[0], in0), simd::mul(k[1], in1)),
+                                                      simd::add(simd::mul(k[2], in2), simd::mul(k[3], in3))),
+                                            simd::add(simd::mul(k[4], x), simd::mul(k[5], y)));
+            return out;
+        }
+
+        template<typename SampleType>
+        static inline void makeKernel(const Port& inPort, Kernel<SampleType>& outKernel)
+        {
+            const float64 a0 = inPort.mCoefficients[0];
+            const float64 a1 = inPort.mCoefficients[1];
+            const float64 a2 = inPort.mCoefficients[2];
+            const float64 b1 = inPort.mCoefficients[4];
+            const float64 b2 = inPort.mCoefficients[5];
+
+            // s[n+1] = A.s[n] + B.in[n], out[n] = s[n].x + a0.in[n], with A = |-b1 1|
+            //                                                               |-b2 0|
+            // The kernel runs on T.s, T = |1 0|, so its state matrices are T.A^k.T^-1
+            //                             |1 1|
+            const float64 bx = a1 - b1 * a0;
+            const float64 by = a2 - b2 * a0;
+
+            // powers[k] = A^k, stored as { A00, A01, A10, A11 }
+            float64 powers[blockSize + 1][4];
+            powers[0][0] = 1.; powers[0][1] = 0.; powers[0][2] = 0.; powers[0][3] = 1.;
+            for (int k = 1; k <= blockSize; ++k)
+            {
+                const float64* p = powers[k - 1];
+                powers[k][0] = -b1 * p[0] + p[2];
+                powers[k][1] = -b1 * p[1] + p[3];
+                powers[k][2] = -b2 * p[0];
+                powers[k][3] = -b2 * p[1];
+            }
+
+            SampleType out[blockSize + 2][blockSize];
+            SampleType next[blockSize + 2][blockSize];
+            for (int i = 0; i < blockSize + 2; ++i)
+            {
+                for (int k = 0; k < blockSize; ++k)
+                {
+                    out[i][k]   = SampleType(0);
+                    next[i][k]  = SampleType(0);
+                }
+            }
+
+            for (int k = 0; k < blockSize; ++k)
+            {
+                // Output k: a0.in[k] + sum(j < k) (A^(k-1-j).B).x in[j] + (A^k.T^-1.T.s).x
+                out[k][k] = SampleType(a0);
+                for (int j = 0; j < k; ++j)
+                {
+                    const float64* p = powers[k - 1 - j];
+                    out[j][k] = SampleType(p[0] * bx + p[1] * by);
+                }
+                out[blockSize][k]       = SampleType(powers[k][0] - powers[k][1]);
+                out[blockSize + 1][k]   = SampleType(powers[k][1]);
+
+                // Next state: sum(j) T.A^(3-j).B in[j] + T.A^4.T^-1.T.s
+                const float64* p = powers[blockSize - 1 - k];
+                next[k][0] = SampleType(p[0] * bx + p[1] * by);
+                next[k][1] = SampleType((p[0] + p[2]) * bx + (p[1] + p[3]) * by);
+            }
+            const float64* p = powers[blockSize];
+            next[blockSize][0]      = SampleType(p[0] - p[1]);
+            next[blockSize][1]      = SampleType((p[0] + p[2]) - (p[1] + p[3]));
+            next[blockSize + 1][0]  = SampleType(p[1]);
+            next[blockSize + 1][1]  = SampleType(p[1] + p[3]);
+
+            for (int i = 0; i < blockSize + 2; ++i)
+            {
+                outKernel.mOut[i]   = simd::load(out[i]);
+                outKernel.mNext[i]  = simd::load(next[i]);
+            }
+        }
+    };
+
+    // -------------------------------------------------------------------------
+
+    /*!
+        IIRCascade runs an input Gain, NumSections biquads and an output Gain
+        in a single pass over a group of up to simd::numLanes channels.
+        Every section is applied to a sample frame before moving to the next frame,
+        so that the block is only loaded and stored once, whatever the number of sections.
+        The gains ramp like the scalar Gain recursion does, one decay step per sample frame.
+        Long float64 mono blocks switch to the time-parallel BlockIIR form of the sections.
+        When the section Ports change, the coefficients ramp linearly to them over the block,
+        being updated every interpolationSize samples, so that coefficient jumps do not zipper
+        whatever the host block size. Settled coefficients are used as they are, at no extra cost.
+    */
+    template<int NumSections>
+    struct IIRCascade
+    {
+        enum { numLanes = simd::numLanes, numSections = NumSections, interpolationSize = 32 };
+
+        template<typename SampleType>
+        struct State
+        {
+            SampleType mInputGain[numLanes];
+            MultiIIR::State<SampleType> mSections[NumSections];
+            SampleType mOutputGain[numLanes];
+            SampleType mGainDecay;
+            IIR::Port mCoefficients[NumSections];
+            bool mHasCoefficients;
+        };
+
+        template<typename SampleType>
+        static inline void reset(State<SampleType>& ioState, double inSamplerate)
+        {
+            ioState.mGainDecay = SampleType(Gain::decay(inSamplerate));
+            for (int c = 0; c < numLanes; ++c)
+            {
+                ioState.mInputGain[c]   = SampleType(0);
+                ioState.mOutputGain[c]  = SampleType(0);
+            }
+            for (int k = 0; k < NumSections; ++k)
+            {
+                MultiIIR::reset(ioState.mSections[k]);
+            }
+            ioState.mHasCoefficients = false;
+        }
+        template<typename SampleType>
+        static inline void process(const SampleType*const* inSrc, SampleType*const* outDest,
+                                   int inNumChannels, int inNumSamples,
+                                   const Gain::Port& inInputGain,
+                                   const IIR::Port*const* inSections,
+                                   const Gain::Port& inOutputGain,
+                                   State<SampleType>& ioState)
+        {
+            if (!ioState.mHasCoefficients)
+            {
+                for (int k = 0; k < NumSections; ++k)
+                {
+                    ioState.mCoefficients[k] = *inSections[k];
+                }
+                ioState.mHasCoefficients = true;
+            }
+
+            if (isSettled(inSections, ioState))
+            {
+                processSections(inSrc, outDest, inNumChannels, inNumSamples,
+                                inInputGain, inSections, inOutputGain, ioState);
+                return;
+            }
+
+            const IIR::Port* current[NumSections];
+            for (int k = 0; k < NumSections; ++k)
+            {
+                current[k] = &ioState.mCoefficients[k];
+            }
+
+            const SampleType* src[numLanes];
+            SampleType* dest[numLanes];
+
+            const int numSubBlocks = (inNumSamples + interpolationSize - 1) / interpolationSize;
+            for (int n = 0; n < numSubBlocks; ++n)
+            {
+                const int offset        = n * interpolationSize;
+                const int numSamples    = std::min(int(interpolationSize), inNumSamples - offset);
+                for (int c = 0; c < inNumChannels; ++c)
+                {
+                    src[c]  = inSrc[c] + offset;
+                    dest[c] = outDest[c] + offset;
+                }
+
+                interpolate(inSections, numSubBlocks - n, ioState);
+                processSections(src, dest, inNumChannels, numSamples,
+                                inInputGain, current, inOutputGain, ioState);
+            }
+        }
+
+        /*!
+            The cascade is idle when all its section memories are silent:
+            a silent input block then produces a silent output block.
+        */
+        template<typename SampleType>
+        static inline bool isIdle(const State<SampleType>& inState)
+        {
+            for (int k = 0; k < NumSections; ++k)
+            {
+                for (int c = 0; c < numLanes; ++c)
+                {
+                    if (!Silence::isSilent(inState.mSections[k].mX[c]) ||
+                        !Silence::isSilent(inState.mSections[k].mY[c]))
+                    {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+        /*!
+            Moves an idle cascade inNumSamples forward without processing:
+            the gains ramp on, and the coefficients jump to the Ports as there is nothing to smooth.
+        */
+        template<typename SampleType>
+        static inline void skip(int inNumSamples,
+                                const Gain::Port& inInputGain,
+                                const IIR::Port*const* inSections,
+                                const Gain::Port& inOutputGain,
+                                State<SampleType>& ioState)
+        {
+            for (int c = 0; c < numLanes; ++c)
+            {
+                Gain::State<SampleType> inGain  = { ioState.mInputGain[c], ioState.mGainDecay };
+                Gain::State<SampleType> outGain = { ioState.mOutputGain[c], ioState.mGainDecay };
+                Gain::skip(inNumSamples, inInputGain, inGain);
+                Gain::skip(inNumSamples, inOutputGain, outGain);
+                ioState.mInputGain[c]   = inGain.mCurrentGain;
+                ioState.mOutputGain[c]  = outGain.mCurrentGain;
+            }
+            for (int k = 0; k < NumSections; ++k)
+            {
+                MultiIIR::reset(ioState.mSections[k]);
+                ioState.mCoefficients[k] = *inSections[k];
+            }
+            ioState.mHasCoefficients = true;
+        }
+        /*!
+            The sections are in series, so their tails add up.
+        */
+        static inline float64 tailLength(const IIR::Port*const* inSections, double inSamplerate)
+        {
+            float64 length = 0.;
+            for (int k = 0; k < NumSections; ++k)
+            {
+                length += IIR::tailLength(*inSections[k], inSamplerate);
+            }
+            return std::min(length, IIR::maxTailLength());
+        }
+
+    private:
+        template<typename SampleType>
+        static inline void processSections(const SampleType*const* inSrc, SampleType*const* outDest,
+                                           int inNumChannels, int inNumSamples,
+                                           const Gain::Port& inInputGain,
+                                           const IIR::Port*const* inSections,
+                                           const Gain::Port& inOutputGain,
+                                           State<SampleType>& ioState)
+        {
+            typedef typename simd::Vector<SampleType>::Type Vector;
+
+            if (inNumChannels == 1 && BlockIIR::isEnabled(inNumSamples, SampleType()))
+            {
+                processMono(inSrc[0], outDest[0], inNumSamples, inInputGain, inSections,
+                            inOutputGain, ioState);
+                return;
+            }
+
+            Vector a0[NumSections], a1[NumSections], a2[NumSections];
+            Vector b1[NumSections], b2[NumSections];
+            Vector x[NumSections], y[NumSections];
+
+            for (int k = 0; k < NumSections; ++k)
+            {
+                a0[k]   = simd::set(SampleType(inSections[k]->mCoefficients[0]));
+                a1[k]   = simd::set(SampleType(inSections[k]->mCoefficients[1]));
+                a2[k]   = simd::set(SampleType(inSections[k]->mCoefficients[2]));
+                b1[k]   = simd::set(SampleType(inSections[k]->mCoefficients[4]));
+                b2[k]   = simd::set(SampleType(inSections[k]->mCoefficients[5]));
+                x[k]    = simd::load(ioState.mSections[k].mX);
+                y[k]    = simd::load(ioState.mSections[k].mY);
+            }
+
+            const Vector decay      = simd::set(ioState.mGainDecay);
+            const Vector inTarget   = simd::set(SampleType(inInputGain.mTargetGain));
+            const Vector outTarget  = simd::set(SampleType(inOutputGain.mTargetGain));
+            Vector inGain           = simd::add(inTarget, distance(inInputGain, ioState.mInputGain));
+            Vector outGain          = simd::add(outTarget, distance(inOutputGain, ioState.mOutputGain));
+
+            Lanes<SampleType> lanes(inSrc, outDest, inNumChannels);
+
+            int j = 0;
+            for (; j + numLanes <= inNumSamples; j += numLanes)
+            {
+                Vector f[numLanes];
+                lanes.loadFrames(j, f[0], f[1], f[2], f[3]);
+
+                for (int n = 0; n < numLanes; ++n)
+                {
+                    f[n] = tick(f[n], decay, inTarget, inGain, outTarget, outGain, a0, a1, a2, b1, b2, x, y);
+                }
+
+                lanes.storeFrames(j, f[0], f[1], f[2], f[3]);
+            }
+
+            for (; j < inNumSamples; ++j)
+            {
+                lanes.storeFrame(j, tick(lanes.loadFrame(j), decay, inTarget, inGain,
+                                         outTarget, outGain, a0, a1, a2, b1, b2, x, y));
+            }
+
+            for (int k = 0; k < NumSections; ++k)
+            {
+                MultiIIR::storeState(x[k], y[k], ioState.mSections[k]);
+            }
+            simd::store(ioState.mInputGain, inGain);
+            simd::store(ioState.mOutputGain, outGain);
+        }
+
+        template<typename SampleType>
+        static inline bool isSettled(const IIR::Port*const* inSections, const State<SampleType>& inState)
+        {
+            for (int k = 0; k < NumSections; ++k)
+            {
+                const float64* target   = inSections[k]->mCoefficients;
+                const float64* current  = inState.mCoefficients[k].mCoefficients;
+                if (!std::equal(target, target + 6, current))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /*!
+            Moves the current coefficients a 1 / inNumRemainingSteps of their distance to the Ports,
+            so that they land exactly on them after inNumRemainingSteps calls.
+        */
+        template<typename SampleType>
+        static inline void interpolate(const IIR::Port*const* inSections, int inNumRemainingSteps,
+                                       State<SampleType>& ioState)
+        {
+            const float64 ratio = 1. / inNumRemainingSteps;
+            for (int k = 0; k < NumSections; ++k)
+            {
+                const float64* target   = inSections[k]->mCoefficients;
+                float64* current        = ioState.mCoefficients[k].mCoefficients;
+                for (int i = 0; i < 6; ++i)
+                {
+                    current[i] = inNumRemainingSteps > 1 ? current[i] + (target[i] - current[i]) * ratio
+                                                         : target[i];
+                }
+            }
+        }
+
+        /*!
+            A single channel leaves 3 lanes out of 4 unused,
+            so long float64 mono blocks run the sections in the time-parallel BlockIIR form instead.
+        */
+        template<typename SampleType>
+        static inline void processMono(const SampleType* inSrc, SampleType* outDest,
+                                       int inNumSamples,
+                                       const Gain::Port& inInputGain,
+                                       const IIR::Port*const* inSections,
+                                       const Gain::Port& inOutputGain,
+                                       State<SampleType>& ioState)
+        {
+            typedef typename simd::Vector<SampleType>::Type Vector;
+
+            Gain::State<SampleType> inGain = { ioState.mInputGain[0], ioState.mGainDecay };
+            Gain::process(inSrc, outDest, inNumSamples, inInputGain, inGain);
+            ioState.mInputGain[0] = inGain.mCurrentGain;
+
+            BlockIIR::Kernel<SampleType> kernels[NumSections];
+            Vector states[NumSections];
+            for (int k = 0; k < NumSections; ++k)
+            {
+                BlockIIR::makeKernel(*inSections[k], kernels[k]);
+                const IIR::State<SampleType> section = { ioState.mSections[k].mX[0], ioState.mSections[k].mY[0] };
+                states[k] = BlockIIR::loadState(section);
+            }
+
+            const int numVectorSamples = inNumSamples - inNumSamples % BlockIIR::blockSize;
+            for (int j = 0; j < numVectorSamples; j += BlockIIR::blockSize)
+            {
+                Vector samples = simd::load(outDest + j);
+                for (int k = 0; k < NumSections; ++k)
+                {
+                    samples = BlockIIR::step(samples, kernels[k], states[k]);
+                }
+                simd::store(outDest + j, samples);
+            }
+
+            for (int k = 0; k < NumSections; ++k)
+            {
+                IIR::State<SampleType> section;
+                BlockIIR::storeState(states[k], section);
+                IIR::process(outDest + numVectorSamples, outDest + numVectorSamples,
+                             inNumSamples - numVectorSamples, *inSections[k], section);
+                ioState.mSections[k].mX[0] = section.mX;
+                ioState.mSections[k].mY[0] = section.mY;
+            }
+
+            Gain::State<SampleType> outGain = { ioState.mOutputGain[0], ioState.mGainDecay };
+            Gain::process(outDest, outDest, inNumSamples, inOutputGain, outGain);
+            ioState.mOutputGain[0] = outGain.mCurrentGain;
+        }
+
+        /*!
+            Returns the distance of each lane gain to the Port target,
+            settled lanes being snapped to it the same way Gain does.
+        */
+        template<typename SampleType>
+        static inline typename simd::Vector<SampleType>::Type distance(const Gain::Port& inPort,
+                                                                       const SampleType* inGains)
+        {
+            const SampleType target     = SampleType(inPort.mTargetGain);
+            const SampleType epsilon    = SampleType(1e-9);
+            SampleType deltas[numLanes];
+            for (int c = 0; c < numLanes; ++c)
+            {
+                const SampleType delta = inGains[c] - target;
+                deltas[c] = std::abs(delta) < epsilon ? SampleType(0) : delta;
+            }
+            return simd::load(deltas);
+        }
+
+        /*!
+            The gains step the way the scalar recursion does, from their rounded value,
+            so that rounding does not accumulate along the ramp.
+        */
+        template<typename Vector>
+        static inline Vector tick(Vector inSample, Vector inDecay,
+                                  Vector inInTarget, Vector& ioInGain,
+                                  Vector inOutTarget, Vector& ioOutGain,
+                                  const Vector* inA0, const Vector* inA1,
+                                  const Vector* inA2, const Vector* inB1,
+                                  const Vector* inB2,
+                                  Vector* ioX, Vector* ioY)
+        {
+            ioInGain = simd::add(inInTarget, simd::mul(simd::sub(ioInGain, inInTarget), inDecay));
+            Vector sample = simd::mul(inSample, ioInGain);
+
+            for (int k = 0; k < NumSections; ++k)
+            {
+                sample = MultiIIR::tick(sample, inA0[k], inA1[k], inA2[k], inB1[k], inB2[k],
+                                        ioX[k], ioY[k]);
+            }
+
+            ioOutGain = simd::add(inOutTarget, simd::mul(simd::sub(ioOutGain, inOutTarget), inDecay));
+            return simd::mul(sample, ioOutGain);
         }
     };
 
@@ -7,5 +7,15 @@
 
 namespace dsp
 {
+    SinCosTable::SinCosTable()
+    {
+        for (int i = 0; i <= numEntries; ++i)
+        {
+            const float64 w = pi_64 * float64(i) / float64(numEntries);
+            mEntries[i][0]  = std::sin(w);
+            mEntries[i][1]  = std::cos(w);
+        }
+    }
 
+    const SinCosTable gSinCosTable;
 }
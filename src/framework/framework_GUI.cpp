@@ -53,12 +53,12 @@ namespace gui
 
     juce::String Control::getControlValueText(float inValue) const
     {
-        return mParameterInfo.mDisplayDelegate->toText(inValue);
+        return mParameterInfo.mDisplayDelegate->toText(*mParameterInfo.mTaper, inValue);
     }
 
     bool Control::getControlValueFromText(const juce::String& inText, float& outValue) const
     {
-        return mParameterInfo.mDisplayDelegate->fromText(inText, outValue);
+        return mParameterInfo.mDisplayDelegate->fromText(*mParameterInfo.mTaper, inText, outValue);
     }
 
     float Control::getNormalizedDefaultValue() const
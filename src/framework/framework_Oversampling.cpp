@@ -0,0 +1,11 @@
+/*!
+ * \file       framework_Oversampling.cpp
+ * Copyright   Eiosis 2014
+ */
+
+#include "framework/framework_Oversampling.h"
+
+namespace dsp
+{
+
+}
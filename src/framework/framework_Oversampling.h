@@ -0,0 +1,388 @@
+/*!
+ * \file       framework_Oversampling.h
+ * Copyright   Eiosis 2014
+ */
+
+#pragma once
+
+#include "framework/framework_Cells.h"
+
+#include <cstring>
+#include <vector>
+
+namespace dsp
+{
+    /*!
+        HalfBand is a polyphase half-band FIR stage, doubling (upsample) or halving (downsample) the samplerate.
+        Every other tap of a half-band FIR is null but the center one (one half), so that one polyphase
+        branch is a plain delay, and the other one a symmetric FIR of 2 * NumTaps taps,
+        computed numLanes samples at a time.
+        The delay branch lags the FIR branch by half a low rate sample, so that both upsample and downsample
+        have a latency of exactly NumTaps low rate samples.
+        Lines are the historySize previous samples of a branch, followed by the block samples.
+    */
+    template<int NumTaps>
+    struct HalfBand
+    {
+        enum { numTaps = NumTaps, historySize = 2 * NumTaps };
+
+        /*!
+            Kaiser windowed sinc, normalized for a unity gain at DC.
+            Only the first half of the symmetric FIR branch is stored.
+        */
+        template<typename SampleType>
+        static inline void design(float64 inBeta, SampleType* outTaps)
+        {
+            float64 taps[NumTaps];
+            float64 sum = 0.;
+            for (int m = 0; m < NumTaps; ++m)
+            {
+                const float64 d     = float64(2 * m - historySize + 1);
+                const float64 r     = d / float64(historySize);
+                taps[m]             = std::sin(halfPi_64 * d) / (halfPi_64 * d) *
+                                      bessel(inBeta * std::sqrt(1. - r * r)) / bessel(inBeta);
+                sum                 += 2. * taps[m];
+            }
+            for (int m = 0; m < NumTaps; ++m)
+            {
+                outTaps[m] = SampleType(taps[m] / sum);
+            }
+        }
+
+        /*!
+            Reads the inNumSamples samples following the history of ioLine,
+            and writes 2 * inNumSamples samples to outDest.
+        */
+        template<typename SampleType>
+        static inline void upsample(SampleType* ioLine, int inNumSamples, const SampleType* inTaps,
+                                    SampleType* outDest)
+        {
+            typedef typename simd::Vector<SampleType>::Type Vector;
+
+            const SampleType* src = ioLine + historySize;
+
+            int n = 0;
+            for (; n + simd::numLanes <= inNumSamples; n += simd::numLanes)
+            {
+                SampleType fir[simd::numLanes];
+                simd::store(fir, convolve<Vector>(src + n, inTaps));
+
+                for (int i = 0; i < simd::numLanes; ++i)
+                {
+                    outDest[2 * (n + i)]        = src[n + i - NumTaps];
+                    outDest[2 * (n + i) + 1]    = fir[i];
+                }
+            }
+            for (; n < inNumSamples; ++n)
+            {
+                outDest[2 * n]      = src[n - NumTaps];
+                outDest[2 * n + 1]  = convolve(src + n, inTaps);
+            }
+
+            std::memmove(ioLine, ioLine + inNumSamples, historySize * sizeof(SampleType));
+        }
+
+        /*!
+            Reads 2 * inNumSamples samples from inSrc into the even and odd lines,
+            and writes inNumSamples samples to outDest, which may be inSrc.
+        */
+        template<typename SampleType>
+        static inline void downsample(const SampleType* inSrc, int inNumSamples,
+                                      SampleType* ioEvenLine, SampleType* ioOddLine,
+                                      const SampleType* inTaps, SampleType* outDest)
+        {
+            typedef typename simd::Vector<SampleType>::Type Vector;
+
+            SampleType* even    = ioEvenLine + historySize;
+            SampleType* odd     = ioOddLine + historySize;
+            for (int n = 0; n < inNumSamples; ++n)
+            {
+                even[n] = inSrc[2 * n];
+                odd[n]  = inSrc[2 * n + 1];
+            }
+
+            const SampleType half = SampleType(.5);
+
+            int n = 0;
+            for (; n + simd::numLanes <= inNumSamples; n += simd::numLanes)
+            {
+                const Vector sum = simd::add(simd::load(even + n - NumTaps), convolve<Vector>(odd + n - 1, inTaps));
+                simd::store(outDest + n, simd::mul(simd::set(half), sum));
+            }
+            for (; n < inNumSamples; ++n)
+            {
+                outDest[n] = half * (even[n - NumTaps] + convolve(odd + n - 1, inTaps));
+            }
+
+            std::memmove(ioEvenLine, ioEvenLine + inNumSamples, historySize * sizeof(SampleType));
+            std::memmove(ioOddLine, ioOddLine + inNumSamples, historySize * sizeof(SampleType));
+        }
+
+    private:
+        /*!
+            FIR branch output at inSrc, folding the symmetric taps.
+        */
+        template<typename Vector, typename SampleType>
+        static inline Vector convolve(const SampleType* inSrc, const SampleType* inTaps)
+        {
+            Vector acc = simd::set(SampleType(zero));
+            for (int k = 0; k < NumTaps; ++k)
+            {
+                const Vector pair = simd::add(simd::load(inSrc - k), simd::load(inSrc + k + 1 - historySize));
+                acc = simd::add(acc, simd::mul(simd::set(inTaps[k]), pair));
+            }
+            return acc;
+        }
+
+        template<typename SampleType>
+        static inline SampleType convolve(const SampleType* inSrc, const SampleType* inTaps)
+        {
+            SampleType acc = zero;
+            for (int k = 0; k < NumTaps; ++k)
+            {
+                acc += inTaps[k] * (inSrc[-k] + inSrc[k + 1 - historySize]);
+            }
+            return acc;
+        }
+
+        static inline float64 bessel(float64 inValue)
+        {
+            float64 sum     = 1.;
+            float64 term    = 1.;
+            for (int k = 1; k < 32; ++k)
+            {
+                const float64 factor = inValue / (2. * k);
+                term    *= factor * factor;
+                sum     += term;
+            }
+            return sum;
+        }
+    };
+
+    // -------------------------------------------------------------------------
+
+    /*!
+        Oversampler runs a set of cells at 2, 4 or 8 times the host samplerate,
+        through a cascade of HalfBand stages, each one shorter than the previous one
+        since its transition band gets wider.
+        Stage 1 is flat to .42 times the host samplerate within 1e-4 dB, all stages reject images by 90 dB or more.
+        Buffers are allocated by reset, for up to inMaxNumSamples host samples per call,
+        larger blocks being processed in several calls to the cells.
+        With a factor of 1 the cells process the host buffers directly.
+        A State points into its own memory, and is not to be copied once reset.
+    */
+    struct Oversampler
+    {
+        enum { maxNumStages = 3, maxFactor = 1 << maxNumStages };
+
+        typedef HalfBand<24>    Stage1;
+        typedef HalfBand<8>     Stage2;
+        typedef HalfBand<4>     Stage3;
+
+        template<typename SampleType>
+        struct State
+        {
+            int mFactor;
+            int mNumStages;
+            int mNumChannels;
+            int mMaxNumSamples;
+            SampleType mTaps1[Stage1::numTaps];
+            SampleType mTaps2[Stage2::numTaps];
+            SampleType mTaps3[Stage3::numTaps];
+            std::vector<SampleType> mMemory;
+            std::vector<SampleType*> mChannels;     //<! Oversampled channels
+            std::vector<SampleType*> mLines;        //<! Up, even and odd lines of each stage and channel
+        };
+
+        /*!
+            Allocates the buffers: not to be called from the audio thread.
+            inFactor is 1, 2, 4 or maxFactor.
+        */
+        template<typename SampleType>
+        static inline void reset(State<SampleType>& ioState, int inFactor, int inNumChannels, int inMaxNumSamples)
+        {
+            ioState.mFactor         = inFactor;
+            ioState.mNumStages      = 0;
+            ioState.mNumChannels    = inNumChannels;
+            ioState.mMaxNumSamples  = std::max(inMaxNumSamples, 1);
+            while ((1 << ioState.mNumStages) < inFactor)
+            {
+                ++ioState.mNumStages;
+            }
+
+            Stage1::design(10., ioState.mTaps1);
+            Stage2::design(10., ioState.mTaps2);
+            Stage3::design(10., ioState.mTaps3);
+
+            if (inFactor == 1)
+            {
+                std::vector<SampleType>().swap(ioState.mMemory);
+                ioState.mChannels.clear();
+                ioState.mLines.clear();
+                return;
+            }
+
+            const int channelSize = ioState.mMaxNumSamples * inFactor;
+            int size = channelSize * inNumChannels;
+            for (int s = 0; s < ioState.mNumStages; ++s)
+            {
+                size += 3 * inNumChannels * (historySize(s) + (ioState.mMaxNumSamples << s));
+            }
+            ioState.mMemory.assign(size, SampleType(zero));
+            ioState.mChannels.resize(inNumChannels);
+            ioState.mLines.resize(3 * ioState.mNumStages * inNumChannels);
+
+            SampleType* memory = &ioState.mMemory[0];
+            for (int c = 0; c < inNumChannels; ++c)
+            {
+                ioState.mChannels[c] = memory;
+                memory += channelSize;
+            }
+            for (int s = 0; s < ioState.mNumStages; ++s)
+            {
+                for (int l = 0; l < 3 * inNumChannels; ++l)
+                {
+                    ioState.mLines[3 * s * inNumChannels + l] = memory;
+                    memory += historySize(s) + (ioState.mMaxNumSamples << s);
+                }
+            }
+        }
+
+        /*!
+            Host samples it takes for a signal to go through the up and down stages.
+        */
+        static inline int latency(int inFactor)
+        {
+            int res = 0;
+            for (int s = 0; (1 << s) < inFactor; ++s)
+            {
+                res += (2 * numTaps(s)) >> s;
+            }
+            return res;
+        }
+
+        /*!
+            Smallest factor for the cells to run at inMinSamplerate or above.
+        */
+        static inline int factor(double inSamplerate, double inMinSamplerate)
+        {
+            int res = 1;
+            while (res < maxFactor && res * inSamplerate < inMinSamplerate)
+            {
+                res *= 2;
+            }
+            return res;
+        }
+
+        /*!
+            Upsamples inSrc, runs inCells in place on the oversampled channels, and downsamples them to outDest.
+            inCells is called as inCells(inChannels, outChannels, numChannels, numSamples).
+        */
+        template<typename SampleType, class CellsType>
+        static inline void process(const SampleType*const* inSrc, SampleType*const* outDest,
+                                   int inNumChannels, int inNumSamples,
+                                   State<SampleType>& ioState, const CellsType& inCells)
+        {
+            if (ioState.mFactor == 1)
+            {
+                inCells(inSrc, outDest, inNumChannels, inNumSamples);
+                return;
+            }
+
+            const int numChannels = std::min(inNumChannels, ioState.mNumChannels);
+
+            for (int offset = 0; offset < inNumSamples; offset += ioState.mMaxNumSamples)
+            {
+                const int numSamples = std::min(inNumSamples - offset, ioState.mMaxNumSamples);
+                for (int c = 0; c < numChannels; ++c)
+                {
+                    upsample(inSrc[c] + offset, c, numSamples, ioState);
+                }
+                inCells(&ioState.mChannels[0], &ioState.mChannels[0], numChannels, numSamples * ioState.mFactor);
+                for (int c = 0; c < numChannels; ++c)
+                {
+                    downsample(c, numSamples, outDest[c] + offset, ioState);
+                }
+            }
+        }
+
+    private:
+        static inline int numTaps(int inStage)
+        {
+            return inStage == 0 ? int(Stage1::numTaps) : inStage == 1 ? int(Stage2::numTaps) : int(Stage3::numTaps);
+        }
+
+        static inline int historySize(int inStage)
+        {
+            return 2 * numTaps(inStage);
+        }
+
+        template<typename SampleType>
+        static inline SampleType* line(const State<SampleType>& inState, int inStage, int inChannel, int inLine)
+        {
+            return inState.mLines[3 * (inStage * inState.mNumChannels + inChannel) + inLine];
+        }
+
+        /*!
+            Stages whose line is silent are skipped, leaving a silent output and history.
+        */
+        template<typename SampleType>
+        static inline void upsample(const SampleType* inSrc, int inChannel, int inNumSamples, State<SampleType>& ioState)
+        {
+            std::memcpy(line(ioState, 0, inChannel, 0) + historySize(0), inSrc, inNumSamples * sizeof(SampleType));
+
+            for (int s = 0; s < ioState.mNumStages; ++s)
+            {
+                const int numSamples    = inNumSamples << s;
+                SampleType* upLine      = line(ioState, s, inChannel, 0);
+                SampleType* dest        = s + 1 < ioState.mNumStages ?
+                                          line(ioState, s + 1, inChannel, 0) + historySize(s + 1) :
+                                          ioState.mChannels[inChannel];
+
+                if (Silence::isSilent(upLine, historySize(s) + numSamples))
+                {
+                    Silence::clear(upLine, historySize(s));
+                    Silence::clear(dest, 2 * numSamples);
+                    continue;
+                }
+
+                switch (s)
+                {
+                case 0: Stage1::upsample(upLine, numSamples, ioState.mTaps1, dest); break;
+                case 1: Stage2::upsample(upLine, numSamples, ioState.mTaps2, dest); break;
+                case 2: Stage3::upsample(upLine, numSamples, ioState.mTaps3, dest); break;
+                }
+            }
+        }
+
+        template<typename SampleType>
+        static inline void downsample(int inChannel, int inNumSamples, SampleType* outDest, State<SampleType>& ioState)
+        {
+            SampleType* channel = ioState.mChannels[inChannel];
+
+            for (int s = ioState.mNumStages - 1; s >= 0; --s)
+            {
+                const int numSamples    = inNumSamples << s;
+                SampleType* evenLine    = line(ioState, s, inChannel, 1);
+                SampleType* oddLine     = line(ioState, s, inChannel, 2);
+                SampleType* dest        = s > 0 ? channel : outDest;
+
+                if (Silence::isSilent(channel, 2 * numSamples) &&
+                    Silence::isSilent(evenLine, historySize(s)) && Silence::isSilent(oddLine, historySize(s)))
+                {
+                    Silence::clear(evenLine, historySize(s));
+                    Silence::clear(oddLine, historySize(s));
+                    Silence::clear(dest, numSamples);
+                    continue;
+                }
+
+                switch (s)
+                {
+                case 0: Stage1::downsample(channel, numSamples, evenLine, oddLine, ioState.mTaps1, dest); break;
+                case 1: Stage2::downsample(channel, numSamples, evenLine, oddLine, ioState.mTaps2, dest); break;
+                case 2: Stage3::downsample(channel, numSamples, evenLine, oddLine, ioState.mTaps3, dest); break;
+                }
+            }
+        }
+    };
+}
@@ -17,87 +17,62 @@ namespace parameters
 
     // -------------------------------------------------------------------------
 
-    LinearParameterTaper::LinearParameterTaper(float inStartValue, float inEndValue)
-        : mStartValue(inStartValue)
-        , mRange(inEndValue - inStartValue)
-        , mIRange(1.f / mRange)
+    ParameterTaper::ParameterTaper()
+        : mMinValue(0.f)
+        , mFullRange(1.f)
+        , mInverseRange(1.f)
+        , mFlip(0.f)
+        , mExponent(1.f)
+        , mInverseExponent(1.f)
+        , mNumSteps(0.f)
+        , mLastStep(-1.f)
     {
 
     }
 
-    LinearParameterTaper::~LinearParameterTaper()
+    ParameterTaper::ParameterTaper(float inStartValue, float inEndValue, float inExponent, int inNumSteps)
+        : mMinValue(std::min(inStartValue, inEndValue))
+        , mFullRange(std::abs(inEndValue - inStartValue))
+        , mInverseRange(1.f / mFullRange)
+        , mFlip(inStartValue > inEndValue ? 1.f : 0.f)
+        , mExponent(inExponent)
+        , mInverseExponent(1.f / inExponent)
+        , mNumSteps(float(inNumSteps))
+        , mLastStep(float(inNumSteps - 1))
     {
 
     }
 
-    float LinearParameterTaper::getNormalized(float inPlainValue) const
-    {
-        return (inPlainValue - mStartValue) * mIRange;
-    }
+    // -------------------------------------------------------------------------
 
-    float LinearParameterTaper::getPlain(float inNormalizedValue) const
+    LinearParameterTaper::LinearParameterTaper(float inStartValue, float inEndValue)
+        : ParameterTaper(inStartValue, inEndValue, 1.f, 0)
     {
-        return mStartValue + inNormalizedValue * mRange;
+
     }
 
     // -------------------------------------------------------------------------
 
+    /*!
+        The exponent takes inMidValue to inMidPosition.
+    */
     LogParameterTaper::LogParameterTaper(float inStartValue, float inEndValue,
                                          float inMidValue, float inMidPosition)
-        : mInvert(inStartValue > inEndValue)
-        , mMinValue(mInvert ? inEndValue : inStartValue)
-        , mFullRange(std::abs(inEndValue - inStartValue))
-        , mMapFactor(std::log10((inMidValue - mMinValue) / mFullRange) / std::log10(inMidPosition))
-        , mNormalizeFactor(1.f / mMapFactor)
-    {
-
-    }
-
-    LogParameterTaper::~LogParameterTaper()
-    {
-
-    }
-
-    float LogParameterTaper::getNormalized(float inPlainValue) const
+        : ParameterTaper(inStartValue, inEndValue,
+                         std::log10((inMidValue - std::min(inStartValue, inEndValue)) /
+                                    std::abs(inEndValue - inStartValue)) / std::log10(inMidPosition), 0)
     {
-        const float val = ranged(mMinValue, mMinValue + mFullRange, inPlainValue);
-        const float res = std::pow((val - mMinValue) / mFullRange, mNormalizeFactor);
-        return mInvert ? 1.f - res : res;
-    }
 
-    float LogParameterTaper::getPlain(float inNormalizedValue) const
-    {
-        if (mInvert)
-        {
-            inNormalizedValue = 1.f - inNormalizedValue;
-        }
-        return mFullRange * std::pow(inNormalizedValue, mMapFactor) + mMinValue;
     }
 
     // -------------------------------------------------------------------------
 
     EnumeratedParameterTaper::EnumeratedParameterTaper(int inNumValues)
-        : mNumValues(inNumValues)
+        : ParameterTaper(0.f, float(inNumValues - 1), 1.f, inNumValues)
     {
 
     }
 
-    EnumeratedParameterTaper::~EnumeratedParameterTaper()
-    {
-
-    }
-
-    float EnumeratedParameterTaper::getNormalized(float inPlainValue) const
-    {
-        return float(2 * inPlainValue + 1) / float(2 * mNumValues);
-    }
-
-    float EnumeratedParameterTaper::getPlain(float inNormalizedValue) const
-    {
-        return float(std::min(mNumValues - 1,
-                              static_cast<int>(std::floor(inNormalizedValue * mNumValues))));
-    }
-
     // -------------------------------------------------------------------------
 
     ValueSuffixDisplayDelegate::ValueSuffixDisplayDelegate(const char* inSuffix,
@@ -110,33 +85,32 @@ namespace parameters
 
     }
 
-    juce::String ValueSuffixDisplayDelegate::toText(float inValue) const
+    juce::String ValueSuffixDisplayDelegate::toText(const ParameterTaper& inTaper, float inValue) const
     {
-        jassert(mTaper != 0);
         char buf[64];
         std::memset(buf, 0, 64);
-        const float val = mTaper->getPlain(inValue);
+        const float val = inTaper.getPlain(inValue);
 
         if (mDisplaySign)
         {
             sprintf(buf, "%s%.*f%s", val == 0.f ? "" : val > 0.f ? "+" : "-",
-                    mNumDecimals, std::abs(val), mSuffix.c_str());
+                    mNumDecimals, std::abs(val), mSuffix);
         }
         else
         {
             if (val < 1000.f)
             {
-                sprintf(buf, "%.*f%s", mNumDecimals, val, mSuffix.c_str());
+                sprintf(buf, "%.*f%s", mNumDecimals, val, mSuffix);
             }
             else
             {
-                sprintf(buf, "%.*fk%s", mNumDecimals, val * .001f, mSuffix.c_str());
+                sprintf(buf, "%.*fk%s", mNumDecimals, val * .001f, mSuffix);
             }
         }
         return juce::String(buf, strlen(buf));
     }
 
-    bool ValueSuffixDisplayDelegate::fromText(const juce::String& inText,
+    bool ValueSuffixDisplayDelegate::fromText(const ParameterTaper& inTaper, const juce::String& inText,
                                               float& outValue) const
     {
         char buffer[128];
@@ -158,7 +132,7 @@ namespace parameters
         float plainValue;
         if (sscanf(buffer, "%g %*s", &plainValue) == 1)
         {
-            outValue = ranged(0.f, 1.f, mTaper->getNormalized(factor * plainValue));
+            outValue = ranged(0.f, 1.f, inTaper.getNormalized(factor * plainValue));
             return true;
         }
         return false;
@@ -174,24 +148,23 @@ namespace parameters
 
     }
 
-    juce::String EnumeratedDisplayDelegate::toText(float inValue) const
+    juce::String EnumeratedDisplayDelegate::toText(const ParameterTaper& inTaper, float inValue) const
     {
-        jassert(mTaper != 0);
         char buf[64];
         std::memset(buf, 0, 64);
-        const unsigned val = static_cast<unsigned>(mTaper->getPlain(inValue));
+        const unsigned val = static_cast<unsigned>(inTaper.getPlain(inValue));
         jassert(val < mNumValues)
         return mValues[val];
     }
 
-    bool EnumeratedDisplayDelegate::fromText(const juce::String& inText,
+    bool EnumeratedDisplayDelegate::fromText(const ParameterTaper& inTaper, const juce::String& inText,
                                              float& outValue) const
     {
         for (unsigned i = 0; i < mNumValues; ++i)
         {
             if (inText == mValues[i])
             {
-                outValue = mTaper->getNormalized(float(i));
+                outValue = inTaper.getNormalized(float(i));
                 return true;
             }
         }
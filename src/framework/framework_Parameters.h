@@ -6,6 +6,7 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "framework/framework_DSP.h"
 
 namespace parameters
 {
@@ -13,15 +14,52 @@ namespace parameters
         A Taper is used to convert a Parameter value between plain and normalized values.
         Tapers are the link between the GUI controls (knobs etc.) and the processor
         and host value representation (which is a normalized value (0.f<->1.f))
+        All tapers are a power curve over the plain range, or a staircase for enumerations,
+        so that a single concrete type converts them all inline and without branches,
+        one parameter at a time or all of them at once (see ParametersInfo).
+        The taper kinds below only differ by their constructor.
     */
     class ParameterTaper
     {
     public:
-        virtual ~ParameterTaper() {}
+        inline float getNormalized(float inPlainValue) const
+        {
+            const float ratio   = (inPlainValue - mMinValue) * mInverseRange;
+            const float clipped = ratio > 0.f ? (ratio < 1.f ? ratio : 1.f) : 0.f;
+            const float curved  = mInverseExponent != 1.f
+                                ? dsp::fast::pow<dsp::fast::single>(clipped, mInverseExponent) : clipped;
+            const float stepped = float(2. * inPlainValue + 1.) / (2.f * mNumSteps);
+            return mNumSteps > 0.f ? stepped : mFlip + (1.f - 2.f * mFlip) * curved;
+        }
+
+        inline float getPlain(float inNormalizedValue) const
+        {
+            const float position    = mFlip + (1.f - 2.f * mFlip) * inNormalizedValue;
+            const float curved      = mExponent != 1.f
+                                    ? dsp::fast::pow<dsp::fast::single>(position, mExponent) : position;
+            const float step        = float(int(std::max(inNormalizedValue, 0.f) * mNumSteps));
+            const float stepped     = step < mLastStep ? step : mLastStep;
+            return mNumSteps > 0.f ? stepped : mMinValue + mFullRange * curved;
+        }
 
-    public: // ParameterTaper
-        virtual float getNormalized(float inPlainValue) const = 0;
-        virtual float getPlain(float inNormalizedValue) const = 0;
+    public:
+        /*!
+            The identity, from [0, 1] to [0, 1].
+        */
+        ParameterTaper();
+
+    protected:
+        ParameterTaper(float inStartValue, float inEndValue, float inExponent, int inNumSteps);
+
+    private:
+        float mMinValue;
+        float mFullRange;
+        float mInverseRange;
+        float mFlip;                //<! 1 when the range is reversed, 0 otherwise
+        float mExponent;            //<! Of the curve from normalized to plain, 1 for affine tapers
+        float mInverseExponent;
+        float mNumSteps;            //<! Of enumerated tapers, 0 for continuous ones
+        float mLastStep;            //<! Eight floats: the batch conversions vectorize over an array of them
     };
 
     // -------------------------------------------------------------------------
@@ -33,19 +71,6 @@ namespace parameters
     {
     public:
         LinearParameterTaper(float inStartValue, float inEndValue);
-        virtual ~LinearParameterTaper();
-
-    public: // ParameterTaper
-        virtual float getNormalized(float inPlainValue) const;
-        virtual float getPlain(float inNormalizedValue) const;
-
-    private:
-        const float mStartValue;
-        const float mRange;
-        const float mIRange;
-
-    private:
-        JUCE_DECLARE_NON_COPYABLE(LinearParameterTaper);
     };
 
     /*
@@ -56,21 +81,6 @@ namespace parameters
     public:
         LogParameterTaper(float inStartValue, float inEndValue,
                           float inMidValue, float inMidPosition);
-        virtual ~LogParameterTaper();
-
-    public: // ParameterTaper
-        virtual float getNormalized(float inPlainValue) const;
-        virtual float getPlain(float inNormalizedValue) const;
-
-    private:
-        const bool mInvert;
-        const float mMinValue;
-        const float mFullRange;
-        const float mMapFactor;
-        const float mNormalizeFactor;
-
-    private:
-        JUCE_DECLARE_NON_COPYABLE(LogParameterTaper);
     };
 
     /*
@@ -80,42 +90,27 @@ namespace parameters
     {
     public:
         explicit EnumeratedParameterTaper(int inNumValues);
-        virtual ~EnumeratedParameterTaper();
-
-    public: // ParameterTaper
-        virtual float getNormalized(float inPlainValue) const;
-        virtual float getPlain(float inNormalizedValue) const;
-
-    private:
-        const int mNumValues;
-
-    private:
-        JUCE_DECLARE_NON_COPYABLE(EnumeratedParameterTaper);
     };
 
     // -------------------------------------------------------------------------
 
     /*!
-        A DisplayDelegate performs the conversion between a normalized value and a value text.
+        A DisplayDelegate performs the conversion between a normalized value and a value text,
+        through the taper of the parameter it displays.
+        Delegates hold no per parameter state, so that parameters displayed alike share one.
     */
     class DisplayDelegate
     {
     public:
         DisplayDelegate()
-            : mTaper(0)
         {}
         virtual ~DisplayDelegate()
         {}
 
     public: // DisplayDelegate
-        virtual juce::String toText(float inValue) const                            = 0;
-        virtual bool fromText(const juce::String& inText, float& outValue) const    = 0;
-
-    public:
-        void setTaper(const ParameterTaper* inTaper) { mTaper = inTaper; }
-
-    protected:
-        const ParameterTaper* mTaper;
+        virtual juce::String toText(const ParameterTaper& inTaper, float inValue) const = 0;
+        virtual bool fromText(const ParameterTaper& inTaper, const juce::String& inText,
+                              float& outValue) const                                    = 0;
 
     private:
         JUCE_DECLARE_NON_COPYABLE(DisplayDelegate);
@@ -134,11 +129,12 @@ namespace parameters
                                             bool inDisplaySign = false);
 
     public: // DisplayDelegate
-        virtual juce::String toText(float inValue) const;
-        virtual bool fromText(const juce::String& inText, float& outValue) const;
+        virtual juce::String toText(const ParameterTaper& inTaper, float inValue) const;
+        virtual bool fromText(const ParameterTaper& inTaper, const juce::String& inText,
+                              float& outValue) const;
 
     private:
-        const std::string mSuffix;
+        const char* mSuffix;
         const int mNumDecimals;
         const bool mDisplaySign;
 
@@ -155,8 +151,9 @@ namespace parameters
         EnumeratedDisplayDelegate(const char* inValues[], unsigned inNumValues);
 
     public: // DisplayDelegate
-        virtual juce::String toText(float inValue) const;
-        virtual bool fromText(const juce::String& inText, float& outValue) const;
+        virtual juce::String toText(const ParameterTaper& inTaper, float inValue) const;
+        virtual bool fromText(const ParameterTaper& inTaper, const juce::String& inText,
+                              float& outValue) const;
 
     private:
         const char*const* mValues;
@@ -170,11 +167,14 @@ namespace parameters
 
     /*!
         A ParameterInfo structure describes a plugin parameter.
+        It is an aggregate of constants and addresses, so that a table of them is laid out by the
+        compiler and linker, with nothing to run at load: tapers and delegates are static objects
+        of the plugin, shared by the parameters that convert and display alike.
     */
     struct ParameterInfo
     {
         int mIndex;                                 //<! Parameter Index
-        juce::String mName;                         //<! Parameter Name
+        const char* mName;                          //<! Parameter Name
         float mDefaultValue;                        //<! Parameter plain default value
         const ParameterTaper* mTaper;               //<! The Taper that this parameter should use to convert normalized<=>plain
         const DisplayDelegate* mDisplayDelegate;    //<! The DisplayDelegate this parameter should use to convert value<=>text
@@ -183,16 +183,18 @@ namespace parameters
     };
 
     /*!
-        ParametersInfo structure stores all this plugin parameters.
-        Each Plugin should instantiate and fill its own static ParameterInfo structure.
+        ParametersInfo structure gives access to all this plugin parameters,
+        and keeps a copy of their tapers side by side for the batch conversions.
+        Each Plugin defines one, over its ParameterInfo table, in a single translation unit,
+        and declares it extern for the others.
     */
     template<unsigned NumParameters>
     struct ParametersInfo
     {
-        ParametersInfo();
-        ~ParametersInfo();
+        explicit ParametersInfo(const ParameterInfo (&inInfos)[NumParameters]);
 
-        ParameterInfo mInfos[NumParameters];
+        const ParameterInfo* mInfos;
+        ParameterTaper mTapers[NumParameters];
 
         inline const ParameterInfo& operator[](unsigned inIndex) const
         {
@@ -200,10 +202,25 @@ namespace parameters
             return mInfos[inIndex];
         }
 
-    protected:
-        void registerInfo(unsigned inIndex, const char* inName, float inDefaultValue,
-                          ParameterTaper* inTaper, DisplayDelegate* inDisplayDelegate,
-                          size_t inPortId, size_t inPortSize);
+        /*!
+            Convert all the parameter values at once, for preset loads and full mappings.
+        */
+        inline void getPlainValues(const float (&inNormalizedValues)[NumParameters],
+                                   float (&outPlainValues)[NumParameters]) const
+        {
+            for (unsigned i = 0; i < NumParameters; ++i)
+            {
+                outPlainValues[i] = mTapers[i].getPlain(inNormalizedValues[i]);
+            }
+        }
+        inline void getNormalizedValues(const float (&inPlainValues)[NumParameters],
+                                        float (&outNormalizedValues)[NumParameters]) const
+        {
+            for (unsigned i = 0; i < NumParameters; ++i)
+            {
+                outNormalizedValues[i] = mTapers[i].getNormalized(inPlainValues[i]);
+            }
+        }
 
     private:
         ParametersInfo(const ParametersInfo&);
@@ -213,37 +230,13 @@ namespace parameters
     // -------------------------------------------------------------------------
 
     template<unsigned NumParameters>
-    ParametersInfo<NumParameters>::ParametersInfo()
-    {
-
-    }
-
-    template<unsigned NumParameters>
-    ParametersInfo<NumParameters>::~ParametersInfo()
+    ParametersInfo<NumParameters>::ParametersInfo(const ParameterInfo (&inInfos)[NumParameters])
+        : mInfos(inInfos)
     {
         for (unsigned i = 0; i < NumParameters; ++i)
         {
-            delete mInfos[i].mDisplayDelegate;
-            delete mInfos[i].mTaper;
+            jassert(inInfos[i].mIndex == int(i) && inInfos[i].mTaper != 0 && inInfos[i].mDisplayDelegate != 0);
+            mTapers[i] = *inInfos[i].mTaper;
         }
     }
-
-    template<unsigned NumParameters>
-    void ParametersInfo<NumParameters>::registerInfo(unsigned inIndex, const char* inName,
-                                                     float inDefaultValue,
-                                                     ParameterTaper* inTaper,
-                                                     DisplayDelegate* inDisplayDelegate,
-                                                     size_t inPortId, size_t inPortSize)
-    {
-        jassert(inIndex < NumParameters);
-        ParameterInfo& info     = mInfos[inIndex];
-        info.mIndex             = inIndex;
-        info.mName              = inName;
-        info.mDefaultValue      = inDefaultValue;
-        info.mTaper             = inTaper;
-        info.mDisplayDelegate   = inDisplayDelegate;
-        info.mPortId            = inPortId;
-        info.mPortSize          = inPortSize;
-        inDisplayDelegate->setTaper(inTaper);
-    }
 }
@@ -11,7 +11,9 @@ namespace plugin
 {
     static const unsigned int gStateMagic       = 0xdeadbeef;
     static const unsigned int gStateVersion     = 0x0001;
-    static const unsigned int gNumMaxChannels   = 2;
+    static const unsigned int gNumMaxChannels   = 16;   //<! Up to 7.1.4 or third order ambisonics
+    static const int gNumMaxParameterEvents     = 1024; //<! Scheduled ahead of the audio thread
+    static const int gMinNumSubBlockSamples     = 32;   //<! Closer events are applied together
 
     /*!
         A State is what is stored in an host chunk or a preset.
@@ -29,60 +31,149 @@ namespace plugin
     // -------------------------------------------------------------------------
 
     /*!
-        This DoubleBuffer class is used to store the plugin ports.
-        Pending member stores the next algorithm configuration,
-        while the Current member stores the configuration that is currently used by the plugin.
-        It's up to the Plugin Processor to swap current and pending as soon as it has mapped a parameter change.
-        On each process cycle, the process callback ask for current(),
-        what induces a caching of the current ports values, avoiding locking for too long.
+        A ParameterEvent is a parameter change that takes effect at mSampleTime,
+        counted in samples processed since prepareToPlay.
+        Its port is mapped when it is applied, so that it carries the values
+        the other parameters of that port have by then.
     */
-    template<typename Type>
-    class DoubleBuffer
+    struct ParameterEvent
+    {
+        juce::int64 mSampleTime;
+        int mIndex;
+        float mValue;
+    };
+
+    /*!
+        This EventQueue class is a wait-free FIFO, for one producer and one consumer thread.
+        The consumer may look at the front() event before pop()ing it.
+    */
+    template<typename Type, int Capacity>
+    class EventQueue
     {
     public:
-        DoubleBuffer()
-            : mCurrent(&mA)
-            , mPending(&mB)
+        EventQueue()
+            : mFifo(Capacity)
         {}
 
     public:
-        inline Type cacheCurrent()
+        /*!
+            Returns false when the queue is full.
+        */
+        inline bool push(const Type& inEvent)
         {
-            juce::SpinLock::ScopedLockType lock(mMutex);
-            return *mCurrent;
-        }
-        inline Type* pending()
-        {
-            return mPending;
+            int start1, size1, start2, size2;
+            mFifo.prepareToWrite(1, start1, size1, start2, size2);
+            if (size1 == 0)
+            {
+                return false;
+            }
+            mEvents[start1] = inEvent;
+            mFifo.finishedWrite(1);
+            return true;
         }
 
     public:
-        inline void swapAndCopy()
+        /*!
+            Returns null when the queue is empty.
+        */
+        inline const Type* front() const
+        {
+            int start1, size1, start2, size2;
+            mFifo.prepareToRead(1, start1, size1, start2, size2);
+            return size1 == 0 ? 0 : &mEvents[start1];
+        }
+        inline void pop()
         {
-            juce::SpinLock::ScopedLockType lock(mMutex);
-            *mCurrent = *mPending;
-            std::swap(mCurrent, mPending);
+            mFifo.finishedRead(1);
+        }
+        inline void clear()
+        {
+            mFifo.finishedRead(mFifo.getNumReady());
         }
 
     private:
-        Type mA;
-        Type mB;
-        juce::SpinLock mMutex;
+        juce::AbstractFifo mFifo;
+        Type mEvents[Capacity];
 
     private:
-        Type* mCurrent;
-        Type* mPending;
+        JUCE_DECLARE_NON_COPYABLE(EventQueue);
+    };
+
+    // -------------------------------------------------------------------------
+
+    /*!
+        This DirtyFlags class records which of NumFlags items changed, from any number of threads,
+        for a single consumer to take() them all at once. Repeated changes of an item coalesce in its flag.
+        Setting a flag is a full barrier, so that the consumer sees whatever was written before it.
+    */
+    template<unsigned NumFlags>
+    class DirtyFlags
+    {
+    public:
+        enum { numWords = (NumFlags + 31) / 32 };
+
+    public:
+        inline void set(unsigned inFlag)
+        {
+            jassert(inFlag < NumFlags);
+            juce::Atomic<juce::uint32>& word = mWords[inFlag / 32];
+            const juce::uint32 bit           = juce::uint32(1) << (inFlag % 32);
+            for (;;)
+            {
+                const juce::uint32 current = word.get();
+                if ((current & bit) != 0 || word.compareAndSetBool(current | bit, current))
+                {
+                    return;
+                }
+            }
+        }
+        inline void setAll()
+        {
+            for (unsigned i = 0; i < NumFlags; ++i)
+            {
+                set(i);
+            }
+        }
+
+    public:
+        /*!
+            Clears all flags, returning those that were set in outWords, and whether any was.
+        */
+        inline bool take(juce::uint32 (&outWords)[numWords])
+        {
+            juce::uint32 any = 0;
+            for (int i = 0; i < numWords; ++i)
+            {
+                outWords[i] = mWords[i].get() != 0 ? mWords[i].exchange(0) : 0;
+                any        |= outWords[i];
+            }
+            return any != 0;
+        }
+        static inline bool isSet(const juce::uint32 (&inWords)[numWords], unsigned inFlag)
+        {
+            return (inWords[inFlag / 32] & (juce::uint32(1) << (inFlag % 32))) != 0;
+        }
 
     private:
-        DoubleBuffer(const DoubleBuffer&);
-        DoubleBuffer& operator=(const DoubleBuffer&);
+        juce::Atomic<juce::uint32> mWords[numWords];
     };
 
     // -------------------------------------------------------------------------
 
+    class WorkerPool;
+
+    /*!
+        mWorkers is the pool processState may split its work across,
+        null when the Processor has not enabled workers.
+        mOversampling is the factor cells run at over mSamplerate (see dsp::Oversampler),
+        and mMaxNumSamples the block size the host announced, for sizing buffers in resetState.
+    */
     struct StateBase
     {
         double mSamplerate;
+        int mOversampling;
+        int mMaxNumSamples;
+        WorkerPool* mWorkers;
     };
 
     // -------------------------------------------------------------------------
@@ -94,12 +185,18 @@ namespace plugin
         The State describes the current state of the Processor's Algorithm.
         Ports are configuration data, State is persistent process data,
         such as filters memories, gains, delay lines, samplerate, temp. buffers etc.
+        There is one State per processing precision, as the host may switch between both.
+        mBlockPorts are the Ports the audio thread processes with, and the only copy of them:
+        parameter changes are mapped into them at the start of each block,
+        and those timed within the blocks to come, queued in mEvents, as their time comes.
     */
-    template<class PortsType, class StateType>
+    template<class PortsType, template<typename> class StateType>
     struct Context
     {
-        plugin::DoubleBuffer<PortsType> mPorts;
-        StateType mState;
+        plugin::EventQueue<ParameterEvent, gNumMaxParameterEvents> mEvents;
+        PortsType mBlockPorts;
+        StateType<float> mFloatState;
+        StateType<double> mDoubleState;
     };
 }
 
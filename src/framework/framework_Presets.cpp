@@ -0,0 +1,522 @@
+/*!
+ * \file       framework_Presets.cpp
+ * Copyright   Eiosis 2014
+ */
+
+#include "framework/framework_Presets.h"
+
+namespace plugin
+{
+    static const int gIndexMagic            = 0x58495045;   //<! "EPIX"
+    static const int gIndexVersion          = 1;
+    static const int gStateHeaderSize       = int(offsetof(State<1>, mParameterValues));
+
+    static const int gMaxLinkDepth          = 32;           //<! Links followed in a row, as ELOOP allows
+
+    inline juce::int64 stateSize(int inNumParameters)
+    {
+        return gStateHeaderSize + juce::int64(sizeof(float)) * inNumParameters;
+    }
+
+    /*!
+        inDirectory with its links followed. Listed from there, subdirectories that are not links
+        are resolved already, so that each directory has a single path whatever the links to it.
+    */
+    inline juce::File resolveDirectory(const juce::File& inDirectory)
+    {
+        juce::File directory = inDirectory;
+        for (int i = 0; i < gMaxLinkDepth && directory.isSymbolicLink(); ++i)
+        {
+            directory = directory.getLinkedTarget();
+        }
+        return directory;
+    }
+
+    // -------------------------------------------------------------------------
+
+    /*!
+        The index as of one scan, never changed once published,
+        so that the next scan reads it from a worker while the editor queries it.
+        Each directory of a scan also lists its presets in a Snapshot of its own.
+    */
+    class PresetIndex::Snapshot : public juce::ReferenceCountedObject
+    {
+    public:
+        typedef juce::ReferenceCountedObjectPtr<Snapshot> Ptr;
+
+    public:
+        explicit Snapshot(int inNumParameters)
+            : mNumParameters(inNumParameters)
+        {}
+
+    public:
+        int size() const
+        {
+            return mPaths.size();
+        }
+
+        const float* getValues(int inIndex) const
+        {
+            return mValues.getRawDataPointer() + inIndex * mNumParameters;
+        }
+
+        /*!
+            Index of the preset at inPath, -1 if none.
+        */
+        int indexOf(const juce::String& inPath) const
+        {
+            return mIndices.contains(inPath) ? mIndices[inPath] : -1;
+        }
+
+        void add(const juce::String& inPath, juce::int64 inModificationTime, juce::int64 inSize,
+                 const float* inValues)
+        {
+            mIndices.set(inPath, size());
+            mPaths.add(inPath);
+            mNames.add(juce::File(inPath).getFileNameWithoutExtension());
+            mModificationTimes.add(inModificationTime);
+            mSizes.add(inSize);
+            mValues.addArray(inValues, mNumParameters);
+        }
+
+        void addAll(const Snapshot& inOther)
+        {
+            for (int i = 0; i < inOther.size(); ++i)
+            {
+                add(inOther.mPaths[i], inOther.mModificationTimes[i], inOther.mSizes[i], inOther.getValues(i));
+            }
+        }
+
+    public:
+        bool read(const juce::MemoryBlock& inData)
+        {
+            juce::MemoryInputStream stream(inData, false);
+            if (stream.readInt() != gIndexMagic || stream.readInt() != gIndexVersion ||
+                stream.readInt() != int(gStateMagic) || stream.readInt() != int(gStateVersion) ||
+                stream.readInt() != mNumParameters)
+            {
+                return false;
+            }
+
+            const int numPresets = stream.readInt();
+            juce::HeapBlock<float> values(mNumParameters);
+            for (int i = 0; i < numPresets && !stream.isExhausted(); ++i)
+            {
+                const juce::String path                 = stream.readString();
+                const juce::int64 modificationTime      = stream.readInt64();
+                const juce::int64 size                  = stream.readInt64();
+                for (int p = 0; p < mNumParameters; ++p)
+                {
+                    values[p] = stream.readFloat();
+                }
+                add(path, modificationTime, size, values);
+            }
+            return size() == numPresets;
+        }
+
+        void write(juce::OutputStream& outStream) const
+        {
+            outStream.writeInt(gIndexMagic);
+            outStream.writeInt(gIndexVersion);
+            outStream.writeInt(int(gStateMagic));
+            outStream.writeInt(int(gStateVersion));
+            outStream.writeInt(mNumParameters);
+            outStream.writeInt(size());
+            for (int i = 0; i < size(); ++i)
+            {
+                outStream.writeString(mPaths[i]);
+                outStream.writeInt64(mModificationTimes[i]);
+                outStream.writeInt64(mSizes[i]);
+                const float* values = getValues(i);
+                for (int p = 0; p < mNumParameters; ++p)
+                {
+                    outStream.writeFloat(values[p]);
+                }
+            }
+        }
+
+    public:
+        const int mNumParameters;
+        juce::HashMap<juce::String, int> mIndices;
+        juce::StringArray mPaths;
+        juce::StringArray mNames;
+        juce::Array<juce::int64> mModificationTimes;
+        juce::Array<juce::int64> mSizes;
+        juce::Array<float> mValues;             //<! mNumParameters per preset
+
+    private:
+        JUCE_DECLARE_NON_COPYABLE(Snapshot);
+    };
+
+    // -------------------------------------------------------------------------
+
+    class PresetIndex::LoadJob : public JobQueue::Job
+    {
+    public:
+        explicit LoadJob(PresetIndex& inIndex)
+            : JobQueue::Job(&inIndex)
+            , mIndex(inIndex)
+            , mSnapshot(new Snapshot(inIndex.mNumParameters))
+        {}
+
+    public: // JobQueue::Job
+        virtual void execute()
+        {
+            juce::MemoryBlock data;
+            if (!mIndex.mCacheFile.loadFileAsData(data) || !mSnapshot->read(data))
+            {
+                mSnapshot = new Snapshot(mIndex.mNumParameters);
+            }
+        }
+
+        virtual void completed()
+        {
+            mIndex.loaded(mSnapshot);
+        }
+
+    private:
+        PresetIndex& mIndex;
+        Snapshot::Ptr mSnapshot;
+
+    private:
+        JUCE_DECLARE_NON_COPYABLE(LoadJob);
+    };
+
+    // -------------------------------------------------------------------------
+
+    /*!
+        Lists the presets of one directory, and its resolved subdirectories for the next jobs of the scan.
+    */
+    class PresetIndex::ScanJob : public JobQueue::Job
+    {
+    public:
+        ScanJob(PresetIndex& inIndex, const juce::File& inDirectory)
+            : JobQueue::Job(&inIndex)
+            , mIndex(inIndex)
+            , mDirectory(inDirectory)
+            , mPrevious(inIndex.mSnapshot)
+            , mSnapshot(new Snapshot(inIndex.mNumParameters))
+            , mIsChanged(false)
+        {}
+
+    public: // JobQueue::Job
+        virtual void execute()
+        {
+            const int numParameters = mIndex.mNumParameters;
+            juce::HeapBlock<float> values(numParameters);
+            juce::DirectoryIterator it(mDirectory, false, "*", juce::File::findFilesAndDirectories);
+            bool isDirectory = false;
+            bool isHidden = false;
+            juce::int64 size = 0;
+            juce::Time modificationTime;
+            while (it.next(&isDirectory, &isHidden, &size, &modificationTime, 0, 0))
+            {
+                if (mIndex.mIsAborted.get() != 0)
+                {
+                    return;
+                }
+                if (isHidden)
+                {
+                    continue;
+                }
+                if (isDirectory)
+                {
+                    mSubdirectories.add(resolveDirectory(it.getFile()));
+                    continue;
+                }
+                if (size != stateSize(numParameters))
+                {
+                    continue;
+                }
+
+                const juce::String path     = it.getFile().getFullPathName();
+                const juce::int64 time      = modificationTime.toMilliseconds();
+                const int previous          = mPrevious->indexOf(path);
+                if (previous >= 0 && mPrevious->mModificationTimes[previous] == time &&
+                    mPrevious->mSizes[previous] == size)
+                {
+                    mSnapshot->add(path, time, size, mPrevious->getValues(previous));
+                    continue;
+                }
+
+                // Files of another plugin are read again by each scan, but leave the index as is
+                if (readPreset(it.getFile(), numParameters, values))
+                {
+                    mSnapshot->add(path, time, size, values);
+                    mIsChanged = true;
+                }
+                mIsChanged = mIsChanged || previous >= 0;
+            }
+        }
+
+        virtual void completed()
+        {
+            mIndex.scanned(*mSnapshot, mSubdirectories, mIsChanged);
+        }
+
+    private:
+        /*!
+            Reads the header first, so that files of another plugin or version stop there.
+        */
+        static bool readPreset(const juce::File& inFile, int inNumParameters, float* outValues)
+        {
+            juce::FileInputStream stream(inFile);
+            if (stream.failedToOpen())
+            {
+                return false;
+            }
+
+            unsigned int header[3];
+            if (stream.read(header, gStateHeaderSize) != gStateHeaderSize ||
+                header[0] != gStateMagic || juce::int64(header[1]) != stateSize(inNumParameters) ||
+                header[2] != gStateVersion)
+            {
+                return false;
+            }
+
+            const int valuesSize = int(sizeof(float)) * inNumParameters;
+            return stream.read(outValues, valuesSize) == valuesSize;
+        }
+
+    private:
+        PresetIndex& mIndex;
+        const juce::File mDirectory;
+        const Snapshot::Ptr mPrevious;
+        Snapshot::Ptr mSnapshot;
+        juce::Array<juce::File> mSubdirectories;
+        bool mIsChanged;
+
+    private:
+        JUCE_DECLARE_NON_COPYABLE(ScanJob);
+    };
+
+    // -------------------------------------------------------------------------
+
+    class PresetIndex::WriteJob : public JobQueue::Job
+    {
+    public:
+        WriteJob(PresetIndex& inIndex, Snapshot* inSnapshot)
+            : JobQueue::Job(&inIndex)
+            , mIndex(inIndex)
+            , mSnapshot(inSnapshot)
+        {}
+
+    public: // JobQueue::Job
+        virtual void execute()
+        {
+            juce::MemoryOutputStream stream;
+            mSnapshot->write(stream);
+            mIndex.mCacheFile.getParentDirectory().createDirectory();
+            mIndex.mCacheFile.replaceWithData(stream.getData(), stream.getDataSize());
+        }
+
+        virtual void completed()
+        {
+            mIndex.written();
+        }
+
+    private:
+        PresetIndex& mIndex;
+        const Snapshot::Ptr mSnapshot;
+
+    private:
+        JUCE_DECLARE_NON_COPYABLE(WriteJob);
+    };
+
+    // -------------------------------------------------------------------------
+
+    PresetIndex::PresetIndex(int inNumParameters, const juce::File& inCacheFile)
+        : mNumParameters(inNumParameters)
+        , mCacheFile(inCacheFile)
+        , mSnapshot(new Snapshot(inNumParameters))
+        , mIsBusy(true)
+        , mIsStale(true)
+        , mIsScanRequested(false)
+        , mIsScanChanged(false)
+    {
+        mIsAborted.set(0);
+        mIsBusy = mJobs->post(new LoadJob(*this));
+    }
+
+    PresetIndex::~PresetIndex()
+    {
+        mIsAborted.set(1);
+        mJobs->cancel(this);
+    }
+
+    // -------------------------------------------------------------------------
+
+    void PresetIndex::scan(const juce::Array<juce::File>& inDirectories)
+    {
+        jassert(juce::MessageManager::getInstance()->isThisTheMessageThread());
+        mDirectories        = inDirectories;
+        mIsStale            = false;
+        mIsScanRequested    = true;
+        if (!mIsBusy)
+        {
+            startRequestedScan();
+        }
+    }
+
+    bool PresetIndex::isScanning() const
+    {
+        return mIsBusy;
+    }
+
+    bool PresetIndex::isStale() const
+    {
+        return mIsStale;
+    }
+
+    // -------------------------------------------------------------------------
+
+    void PresetIndex::loaded(Snapshot* inSnapshot)
+    {
+        publish(inSnapshot);
+        mIsBusy = false;
+        startRequestedScan();
+    }
+
+    void PresetIndex::scanned(const Snapshot& inDirectory, const juce::Array<juce::File>& inSubdirectories,
+                              bool inIsChanged)
+    {
+        mScanned->addAll(inDirectory);
+        for (int i = 0; i < inSubdirectories.size(); ++i)
+        {
+            queueDirectory(inSubdirectories.getReference(i));
+        }
+        mIsScanChanged  = mIsScanChanged || inIsChanged;
+        mIsBusy         = postNextJob();
+        if (!mIsBusy)
+        {
+            startRequestedScan();
+        }
+    }
+
+    void PresetIndex::written()
+    {
+        mIsBusy = false;
+        startRequestedScan();
+    }
+
+    // -------------------------------------------------------------------------
+
+    void PresetIndex::startRequestedScan()
+    {
+        if (!mIsScanRequested)
+        {
+            return;
+        }
+        mIsScanRequested    = false;
+        mPendingDirectories.clearQuick();
+        mVisitedDirectories.clear();
+        for (int i = 0; i < mDirectories.size(); ++i)
+        {
+            queueDirectory(resolveDirectory(mDirectories.getReference(i)));
+        }
+        mScanned            = new Snapshot(mNumParameters);
+        mIsScanChanged      = false;
+        mIsBusy             = postNextJob();
+    }
+
+    /*!
+        Queues a resolved directory for the running scan, unless it was queued already.
+    */
+    void PresetIndex::queueDirectory(const juce::File& inDirectory)
+    {
+        const juce::String path = inDirectory.getFullPathName();
+        if (!mVisitedDirectories.contains(path))
+        {
+            mVisitedDirectories.set(path, true);
+            mPendingDirectories.add(inDirectory);
+        }
+    }
+
+    /*!
+        Posts the scan of the next pending directory or, once they are all done, publishes the merged
+        index and posts its cache write if it changed, as soon as a preset was added or updated,
+        or one of the previous ones is gone. Returns false when no job was posted.
+    */
+    bool PresetIndex::postNextJob()
+    {
+        if (mPendingDirectories.size() > 0)
+        {
+            const juce::File directory = mPendingDirectories.getFirst();
+            mPendingDirectories.remove(0);
+            return mJobs->post(new ScanJob(*this, directory));
+        }
+
+        const Snapshot::Ptr scanned = mScanned;
+        mScanned                    = 0;
+        if (!mIsScanChanged && scanned->size() == mSnapshot->size())
+        {
+            return false;
+        }
+        publish(scanned);
+        return mJobs->post(new WriteJob(*this, scanned));
+    }
+
+    void PresetIndex::publish(Snapshot* inSnapshot)
+    {
+        if (inSnapshot != mSnapshot.get())
+        {
+            mSnapshot = inSnapshot;
+            sendChangeMessage();
+        }
+    }
+
+    // -------------------------------------------------------------------------
+
+    int PresetIndex::getNumPresets() const
+    {
+        return mSnapshot->size();
+    }
+
+    juce::File PresetIndex::getFile(int inIndex) const
+    {
+        jassert(inIndex >= 0 && inIndex < mSnapshot->size());
+        return juce::File(mSnapshot->mPaths[inIndex]);
+    }
+
+    juce::String PresetIndex::getName(int inIndex) const
+    {
+        jassert(inIndex >= 0 && inIndex < mSnapshot->size());
+        return mSnapshot->mNames[inIndex];
+    }
+
+    const float* PresetIndex::getParameterValues(int inIndex) const
+    {
+        jassert(inIndex >= 0 && inIndex < mSnapshot->size());
+        return mSnapshot->getValues(inIndex);
+    }
+
+    // -------------------------------------------------------------------------
+
+    juce::Array<int> PresetIndex::findByName(const juce::String& inText) const
+    {
+        juce::Array<int> res;
+        for (int i = 0; i < mSnapshot->size(); ++i)
+        {
+            if (mSnapshot->mNames[i].containsIgnoreCase(inText))
+            {
+                res.add(i);
+            }
+        }
+        return res;
+    }
+
+    juce::Array<int> PresetIndex::findByParameter(int inParameter, float inMinValue, float inMaxValue) const
+    {
+        jassert(inParameter >= 0 && inParameter < mNumParameters);
+        juce::Array<int> res;
+        for (int i = 0; i < mSnapshot->size(); ++i)
+        {
+            const float value = mSnapshot->getValues(i)[inParameter];
+            if (value >= inMinValue && value <= inMaxValue)
+            {
+                res.add(i);
+            }
+        }
+        return res;
+    }
+}
@@ -0,0 +1,103 @@
+/*!
+ * \file       framework_Presets.h
+ * Copyright   Eiosis 2014
+ */
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "framework/framework_Plugin.h"
+#include "framework/framework_Workers.h"
+
+namespace plugin
+{
+    /*!
+        PresetIndex lists the presets of a plugin found in a set of directories, with their
+        normalized parameter values, for the editor to browse and search them.
+        Directories are scanned on the shared JobQueue, one job per directory, each posted once the
+        previous one is done, so that a scan never holds more than one worker and preset saves and loads
+        run next to it. A preset is only opened when its size or modification time differs from the last
+        scan, and files whose size is not the one of a State are skipped unread. The header of the others
+        is checked before their values are read. Directories are scanned once per scan whatever the links
+        that lead to them, so that a link to a parent directory does not loop.
+        The index is kept in a cache file, loaded on construction, and rewritten after each scan
+        that changed it. Queries and scans are made from the message thread, and see the index
+        as of the last scan, listeners being sent a change message each time it is updated.
+        Plugins share one index between their instances, through a juce::SharedResourcePointer
+        to a default constructible subclass that gives the number of parameters and the cache file.
+    */
+    class PresetIndex
+        : public juce::ChangeBroadcaster
+    {
+    public:
+        PresetIndex(int inNumParameters, const juce::File& inCacheFile);
+        virtual ~PresetIndex();
+
+    public:
+        /*!
+            Scans inDirectories and their subdirectories, after the running scan if any.
+            The scan is dropped, and the index left as is, when the JobQueue is full.
+        */
+        void scan(const juce::Array<juce::File>& inDirectories);
+        bool isScanning() const;
+
+        /*!
+            Whether no scan was requested since the index was created:
+            it then only knows the presets of its cache, as of a previous session.
+        */
+        bool isStale() const;
+
+    public:
+        int getNumPresets() const;
+        juce::File getFile(int inIndex) const;
+        juce::String getName(int inIndex) const;
+        const float* getParameterValues(int inIndex) const;
+
+    public:
+        /*!
+            Indices of the presets whose name contains inText, ignoring case.
+        */
+        juce::Array<int> findByName(const juce::String& inText) const;
+
+        /*!
+            Indices of the presets whose normalized value of inParameter is in [inMinValue, inMaxValue].
+        */
+        juce::Array<int> findByParameter(int inParameter, float inMinValue, float inMaxValue) const;
+
+    private:
+        class Snapshot;
+        class LoadJob;
+        class ScanJob;
+        class WriteJob;
+
+    private:
+        void loaded(Snapshot* inSnapshot);
+        void scanned(const Snapshot& inDirectory, const juce::Array<juce::File>& inSubdirectories,
+                     bool inIsChanged);
+        void written();
+
+    private:
+        void startRequestedScan();
+        void queueDirectory(const juce::File& inDirectory);
+        bool postNextJob();
+        void publish(Snapshot* inSnapshot);
+
+    private:
+        juce::SharedResourcePointer<JobQueue> mJobs;
+        const int mNumParameters;
+        const juce::File mCacheFile;
+        juce::ReferenceCountedObjectPtr<Snapshot> mSnapshot;
+        juce::ReferenceCountedObjectPtr<Snapshot> mScanned;     //<! Merged from the directories of the running scan
+        juce::Array<juce::File> mDirectories;                   //<! Of the last scan requested
+        juce::Array<juce::File> mPendingDirectories;            //<! Left to the running scan
+        juce::HashMap<juce::String, bool> mVisitedDirectories;  //<! Resolved paths queued by the running scan
+        bool mIsBusy;                           //<! A job of this index is queued or running
+        bool mIsStale;
+        bool mIsScanRequested;
+        bool mIsScanChanged;                    //<! A directory of the running scan added or updated a preset
+        juce::Atomic<int> mIsAborted;           //<! Read by the running job
+
+    private:
+        JUCE_DECLARE_NON_COPYABLE(PresetIndex);
+    };
+}
@@ -8,24 +8,41 @@
 #include "framework/framework_Parameters.h"
 #include "framework/framework_Plugin.h"
 #include "framework/framework_DSP.h"
+#include "framework/framework_SIMD.h"
+#include "framework/framework_Workers.h"
+#include "framework/framework_Oversampling.h"
 
-/*!
-    This function is called whenever the algorithm state needs to be reset.
-*/
-template<class StateType>
-inline void resetState(StateType& ioState);
+/*
+    Concrete plugins provide, in their own namespace (so that they are found
+    by argument dependent lookup), the two following functions for their StateType:
 
-/*!
-    This is the main audio process callback.
-    This function is specialized in concrete plugins,
-    and is called for processing audio from and to the given buffer,
-    the process configuration is passed through the read-only PortsType,
-    and the algorithm persistent data is stored in the StateType structure.
+    template<typename SampleType>
+    inline void resetState(StateType<SampleType>& ioState);
+
+        This function is called whenever the algorithm state needs to be reset.
+
+    template<typename SampleType>
+    inline void processState(const SampleType*const* inInputChannels, int inNumInputChannels,
+                             SampleType*const* inOutputChannels, int inNumOutputChannels,
+                             int inNumSamples, const PortsType& inPorts,
+                             StateType<SampleType>& ioState);
+
+        This is the main audio process callback.
+        It is called for processing audio from and to the given buffer,
+        the process configuration is passed through the read-only PortsType,
+        and the algorithm persistent data is stored in the StateType structure.
+        When the Processor oversamples, processState wraps its cells in a dsp::Oversampler,
+        and they run at mSamplerate * mOversampling.
+
+    inline double tailLengthSeconds(const PortsType& inPorts, double inSamplerate);
+
+        Returns the time the algorithm output takes to decay to silence
+        once its input has become silent, for the given Ports mapped at inSamplerate.
+
+    Both process functions are instantiated for float32 and float64 samples.
+    processState is expected to skip its cells while their input is silent
+    and their state has decayed (see dsp::Silence), so that silent instances cost next to nothing.
 */
-template<class PortsType, class StateType>
-inline void processState(const dsp::ProcessType*const* inInputChannels, int inNumInputChannels,
-                         dsp::ProcessType*const* inOutputChannels, int inNumOutputChannels,
-                         int inNumSamples, const PortsType& inPorts, StateType& ioState);
 
 // -----------------------------------------------------------------------------
 
@@ -37,20 +54,26 @@ namespace plugin
          * keeping a track of the plugin current state (Parameters)
          * initializing and processing the audio stream
          * saving/loading chunks and presets
+         * switching programs from an in-memory bank
          * handle the conversion between Parameter Values and Algorithm Ports
         This class is template on its number of parameters, its Ports data structure,
-        its state data structure, and on its concrete Mappers type,
-        for which it will store one function per parameter.
+        its state data structure (itself template on the sample type),
+        and on its concrete Mappers type, for which it will store one function per parameter.
+        The Ports are shared by both processing precisions, each precision has its own State.
     */
-    template<unsigned NumParameters, class PortsType, class StateType, class MappersType>
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
     class Processor
         : public juce::AudioProcessor
+        , public ParallelProcessor
     {
     public:
         Processor(const parameters::ParametersInfo<NumParameters>& inParametersInfo,
                   const juce::String& inName, bool inHasEditor);
         virtual ~Processor();
 
+    public: // ParallelProcessor
+        virtual void disableWorkers();
+
     public: // juce::AudioProcessor
         virtual const juce::String getName() const;
 
@@ -59,8 +82,11 @@ namespace plugin
         virtual void releaseResources();
 
     public: // juce::AudioProcessor
-        virtual void processBlock(juce::AudioSampleBuffer& ioAudioBuffer,
-                                 juce::MidiBuffer& ioMidiBuffer);
+        virtual void processBlock(juce::AudioBuffer<float>& ioAudioBuffer,
+                                  juce::MidiBuffer& ioMidiBuffer);
+        virtual void processBlock(juce::AudioBuffer<double>& ioAudioBuffer,
+                                  juce::MidiBuffer& ioMidiBuffer);
+        virtual bool supportsDoublePrecisionProcessing() const;
 
     public: // juce::AudioProcessor
         virtual int getNumParameters();
@@ -99,28 +125,120 @@ namespace plugin
     public:
         const parameters::ParameterInfo& getParameterInfo(int inParamIndex) const;
 
+        /*!
+            Sets inIndex to inValue inSampleOffset samples after the start of the next processBlock,
+            for hosts and renderers that know when their automation changes within a block.
+            To be called from the audio thread between two processBlock calls, in time order.
+            The parameter is mapped when its time comes, into the Ports of the block:
+            processBlock splits its block there, in sub blocks of gMinNumSubBlockSamples at least.
+            When too many changes are pending, it is applied as setParameter does, at the next block.
+        */
+        void scheduleParameter(int inIndex, float inValue, int inSampleOffset);
+
+        /*!
+            Replaces the program bank with one program per State, as getStateInformation saves them,
+            named after inNames. States saved by another plugin or version are skipped.
+            Each program's Ports are mapped here, and again by prepareToPlay, so that setCurrentProgram
+            only hands a copy of them to the next block, which neither runs mappers nor allocates.
+            To be called from the message thread: processing is suspended while the bank is mapped.
+            Returns the number of programs in the bank.
+        */
+        int setPrograms(const juce::StringArray& inNames, const juce::Array<juce::MemoryBlock>& inStates);
+
+    private:
+        template<typename SampleType>
+        inline void processAudioBuffer(juce::AudioBuffer<SampleType>& ioAudioBuffer,
+                                       StateType<SampleType>& ioState);
+
+        inline void applyEvents(juce::int64 inSampleTime);
+        inline void applyPendingProgram();
+
     private:
+        /*!
+            setParameter and setStateInformation only record the values they get, and flag them dirty.
+            Each block starts by mapping the ports of the dirty parameters whose value changed,
+            once per port however many of its parameters changed, into the Ports the block processes with.
+            The changed values are converted to plain ones beforehand, for getParameterPlain,
+            in one ParametersInfo::getPlainValues pass when they are many, as after a preset load.
+            Mappers neither lock nor allocate, so a block runs one mapper per port at most.
+        */
+        inline void mapDirtyParameters();
         inline void mapAllParameters();
-        inline void mapParameter(int inIndex);
+        inline void mapPort(unsigned inPortIndex);
+        inline void updateTailLength();
+        inline void mapPrograms();
 
     protected:
         inline void setMapper(int inIndex, void (MappersType::*inMapper)(void*));
 
     protected:
+        /*!
+            Plain value of inIndex, for the mappers, as converted by the mapping that calls them.
+        */
         inline float getParameterPlain(int inIndex);
 
+        /*!
+            Samplerate the cells run at, to be used by mappers rather than getSampleRate.
+        */
+        inline double getProcessSamplerate() const;
+
+    protected:
+        /*!
+            Opts in for processState to split its work across up to inNumWorkers real-time threads
+            (on top of the audio thread), in tasks of inNumChannelsPerTask channels.
+            The next prepareToPlay creates a pool of one worker less than the bus has tasks,
+            and none for the buses that fit in one task. Blocks of less than inMinWork
+            channels times samples run serially (see WorkerPool::setMinWork).
+        */
+        inline void enableWorkers(int inNumWorkers, int inNumChannelsPerTask,
+                                  int inMinWork = WorkerPool::defaultMinWork);
+
+        /*!
+            Opts in for the cells to run at inMinSamplerate or above when rendering offline:
+            below it, the next prepareToPlay of a non-realtime processor (see setNonRealtime)
+            picks an oversampling factor of 2, 4 or 8, and reports its latency.
+            Realtime processors run at the host samplerate, as oversampling costs twice as much at least.
+            A host going offline while prepared keeps its factor until the next prepareToPlay,
+            so that the latency it compensates does not change under it.
+        */
+        inline void enableOversampling(double inMinSamplerate);
+
     private:
-        typedef parameters::ParametersInfo<NumParameters>   ParametersInfo;
-        typedef State<NumParameters>                        State;
-        typedef Context<PortsType, StateType>               Context;
+        typedef parameters::ParametersInfo<NumParameters>       ParametersInfo;
+        typedef State<NumParameters>                            State;
+        typedef Context<PortsType, StateType>                   Context;
+
+        struct Program
+        {
+            juce::String mName;
+            float mParameterValues[NumParameters];
+            float mPlainValues[NumParameters];
+            PortsType mPorts;                       //<! Mapped at the process samplerate
+            double mTailLengthSeconds;
+        };
 
     private:
         const ParametersInfo& mParametersInfo;
         const juce::String mName;
         const bool mHasEditor;
+        juce::Atomic<double> mTailLengthSeconds;    //<! Written on the audio thread, read by the host
+        int mNumWorkers;
+        int mNumChannelsPerTask;
+        int mMinWork;
+        double mMinProcessSamplerate;
+        int mOversampling;
+        juce::int64 mSampleTime;                    //<! Of the next processBlock, on the audio thread
+        juce::ScopedPointer<WorkerPool> mWorkers;
         State mState;
         Context mContext;
+        unsigned int mPortIndices[NumParameters];   //<! Lowest index of the parameters bound to the same port
+        DirtyFlags<NumParameters> mDirtyParameters;
+        float mMappedValues[NumParameters];         //<! As of the last mapping, on the audio thread
+        float mPlainValues[NumParameters];          //<! Of mState, converted by each mapping, on the audio thread
         void (MappersType::*mMappers[NumParameters])(void*);
+        juce::OwnedArray<Program> mPrograms;        //<! Only changed while processing is suspended
+        int mCurrentProgram;
+        juce::Atomic<int> mPendingProgram;          //<! For the next block to apply, -1 if none
 
     private:
         JUCE_DECLARE_NON_COPYABLE(Processor)
@@ -7,29 +7,56 @@
 
 namespace plugin
 {
-    template<unsigned NumParameters, class PortsType, class StateType, class MappersType>
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
     Processor<NumParameters, PortsType, StateType, MappersType>::Processor(const parameters::ParametersInfo<NumParameters>& inParametersInfo,
                                                                            const juce::String& inName, bool inHasEditor)
         : mParametersInfo(inParametersInfo)
         , mName(inName)
         , mHasEditor(inHasEditor)
+        , mNumWorkers(0)
+        , mNumChannelsPerTask(1)
+        , mMinWork(WorkerPool::defaultMinWork)
+        , mMinProcessSamplerate(0.)
+        , mOversampling(1)
+        , mSampleTime(0)
+        , mCurrentProgram(0)
     {
         std::fill(mMappers, mMappers + NumParameters, (void (MappersType::*)(void*))0);
+        mPendingProgram.set(-1);
 
         mState.mMagic       = plugin::gStateMagic;
         mState.mDataSize    = sizeof(State);
         mState.mVersion     = plugin::gStateVersion;
 
-        mContext.mState.mSamplerate = 0.;
+        mContext.mFloatState.mSamplerate    = 0.;
+        mContext.mDoubleState.mSamplerate   = 0.;
+        mContext.mFloatState.mWorkers       = 0;
+        mContext.mDoubleState.mWorkers      = 0;
+
+        mContext.mFloatState.mOversampling   = 1;
+        mContext.mDoubleState.mOversampling  = 1;
+        mContext.mFloatState.mMaxNumSamples  = 0;
+        mContext.mDoubleState.mMaxNumSamples = 0;
 
         for (unsigned i = 0; i < NumParameters; ++i)
         {
-            jassert(mParametersInfo[i].mTaper != 0 && mParametersInfo[i].mDisplayDelegate != 0);
             mState.mParameterValues[i] = mParametersInfo[i].mTaper->getNormalized(mParametersInfo[i].mDefaultValue);
+            mMappedValues[i]           = mState.mParameterValues[i];
+            mPlainValues[i]            = mParametersInfo[i].mTaper->getPlain(mState.mParameterValues[i]);
+
+            mPortIndices[i] = i;
+            for (unsigned j = 0; j < i; ++j)
+            {
+                if (mParametersInfo[j].mPortId == mParametersInfo[i].mPortId)
+                {
+                    mPortIndices[i] = j;
+                    break;
+                }
+            }
         }
     }
 
-    template<unsigned NumParameters, class PortsType, class StateType, class MappersType>
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
     Processor<NumParameters, PortsType, StateType, MappersType>::~Processor()
     {
 
@@ -37,7 +64,7 @@ namespace plugin
 
     // -------------------------------------------------------------------------
 
-    template<unsigned NumParameters, class PortsType, class StateType, class MappersType>
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
     const juce::String Processor<NumParameters, PortsType, StateType, MappersType>::getName() const
     {
         return mName;
@@ -45,13 +72,13 @@ namespace plugin
 
     // -------------------------------------------------------------------------
 
-    template<unsigned NumParameters, class PortsType, class StateType, class MappersType>
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
     int Processor<NumParameters, PortsType, StateType, MappersType>::getNumParameters()
     {
         return int(NumParameters);
     }
 
-    template<unsigned NumParameters, class PortsType, class StateType, class MappersType>
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
     float Processor<NumParameters, PortsType, StateType, MappersType>::getParameter(int inIndex)
     {
         jassert(inIndex < int(NumParameters));
@@ -62,18 +89,40 @@ namespace plugin
         return 0.f;
     }
 
-    template<unsigned NumParameters, class PortsType, class StateType, class MappersType>
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
     void Processor<NumParameters, PortsType, StateType, MappersType>::setParameter(int inIndex, float inValue)
     {
         jassert(inIndex < int(NumParameters));
         if (inIndex < int(NumParameters))
         {
             mState.mParameterValues[inIndex] = inValue;
-            mapParameter(inIndex);
+            mDirtyParameters.set(unsigned(inIndex));
+        }
+    }
+
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
+    void Processor<NumParameters, PortsType, StateType, MappersType>::scheduleParameter(int inIndex, float inValue,
+                                                                                        int inSampleOffset)
+    {
+        jassert(inIndex < int(NumParameters) && mMappers[inIndex] != 0 && inSampleOffset >= 0);
+        if (inIndex >= int(NumParameters))
+        {
+            return;
+        }
+
+        mState.mParameterValues[inIndex] = inValue;
+
+        ParameterEvent event;
+        event.mSampleTime   = mSampleTime + std::max(inSampleOffset, 0);
+        event.mIndex        = inIndex;
+        event.mValue        = inValue;
+        if (!mContext.mEvents.push(event))
+        {
+            mDirtyParameters.set(unsigned(inIndex));
         }
     }
 
-    template<unsigned NumParameters, class PortsType, class StateType, class MappersType>
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
     const juce::String Processor<NumParameters, PortsType, StateType, MappersType>::getParameterName(int inIndex)
     {
         jassert(inIndex < int(NumParameters));
@@ -84,80 +133,81 @@ namespace plugin
         return juce::String::empty;
     }
 
-    template<unsigned NumParameters, class PortsType, class StateType, class MappersType>
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
     const juce::String Processor<NumParameters, PortsType, StateType, MappersType>::getParameterText(int inIndex)
     {
         jassert(inIndex < int(NumParameters));
         if (inIndex < int(NumParameters))
         {
-            return mParametersInfo[inIndex].mDisplayDelegate->toText(mState.mParameterValues[inIndex]);
+            const parameters::ParameterInfo& info = mParametersInfo[inIndex];
+            return info.mDisplayDelegate->toText(*info.mTaper, mState.mParameterValues[inIndex]);
         }
         return juce::String::empty;
     }
 
     // -------------------------------------------------------------------------
 
-    template<unsigned NumParameters, class PortsType, class StateType, class MappersType>
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
     const juce::String Processor<NumParameters, PortsType, StateType, MappersType>::getInputChannelName(int inIndex) const
     {
         return juce::String(inIndex + 1);
     }
 
-    template<unsigned NumParameters, class PortsType, class StateType, class MappersType>
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
     const juce::String Processor<NumParameters, PortsType, StateType, MappersType>::getOutputChannelName(int inIndex) const
     {
         return juce::String(inIndex + 1);
     }
 
-    template<unsigned NumParameters, class PortsType, class StateType, class MappersType>
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
     bool Processor<NumParameters, PortsType, StateType, MappersType>::isInputChannelStereoPair(int inIndex) const
     {
-        return true;
         (void)inIndex;
+        return getNumInputChannels() == 2;
     }
 
-    template<unsigned NumParameters, class PortsType, class StateType, class MappersType>
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
     bool Processor<NumParameters, PortsType, StateType, MappersType>::isOutputChannelStereoPair(int inIndex) const
     {
-        return true;
         (void)inIndex;
+        return getNumOutputChannels() == 2;
     }
 
     // -------------------------------------------------------------------------
 
-    template<unsigned NumParameters, class PortsType, class StateType, class MappersType>
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
     bool Processor<NumParameters, PortsType, StateType, MappersType>::acceptsMidi() const
     {
         return false;
     }
 
-    template<unsigned NumParameters, class PortsType, class StateType, class MappersType>
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
     bool Processor<NumParameters, PortsType, StateType, MappersType>::producesMidi() const
     {
         return false;
     }
 
-    template<unsigned NumParameters, class PortsType, class StateType, class MappersType>
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
     bool Processor<NumParameters, PortsType, StateType, MappersType>::silenceInProducesSilenceOut() const
     {
-        return false;
+        return true;
     }
 
-    template<unsigned NumParameters, class PortsType, class StateType, class MappersType>
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
     double Processor<NumParameters, PortsType, StateType, MappersType>::getTailLengthSeconds() const
     {
-        return 0.;
+        return mTailLengthSeconds.get();
     }
 
     // -------------------------------------------------------------------------
 
-    template<unsigned NumParameters, class PortsType, class StateType, class MappersType>
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
     juce::AudioProcessorEditor* Processor<NumParameters, PortsType, StateType, MappersType>::createEditor()
     {
         return 0;
     }
 
-    template<unsigned NumParameters, class PortsType, class StateType, class MappersType>
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
     bool Processor<NumParameters, PortsType, StateType, MappersType>::hasEditor() const
     {
         return mHasEditor;
@@ -165,71 +215,259 @@ namespace plugin
 
     // -------------------------------------------------------------------------
 
-    template<unsigned NumParameters, class PortsType, class StateType, class MappersType>
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
     int Processor<NumParameters, PortsType, StateType, MappersType>::getNumPrograms()
     {
-        return 0;
+        return mPrograms.size();
     }
 
-    template<unsigned NumParameters, class PortsType, class StateType, class MappersType>
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
     int Processor<NumParameters, PortsType, StateType, MappersType>::getCurrentProgram()
     {
-        return 0;
+        return mCurrentProgram;
     }
 
-    template<unsigned NumParameters, class PortsType, class StateType, class MappersType>
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
     void Processor<NumParameters, PortsType, StateType, MappersType>::setCurrentProgram(int inIndex)
     {
-        (void)inIndex;
+        jassert(inIndex >= 0 && inIndex < mPrograms.size());
+        if (inIndex < 0 || inIndex >= mPrograms.size())
+        {
+            return;
+        }
+
+        // The values for the host and the editor, the Ports for the next block
+        const Program& program = *mPrograms[inIndex];
+        std::copy(program.mParameterValues, program.mParameterValues + NumParameters, mState.mParameterValues);
+        mCurrentProgram = inIndex;
+        mPendingProgram.set(inIndex);
     }
 
-    template<unsigned NumParameters, class PortsType, class StateType, class MappersType>
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
     const juce::String Processor<NumParameters, PortsType, StateType, MappersType>::getProgramName(int inIndex)
     {
+        jassert(inIndex >= 0 && inIndex < mPrograms.size());
+        if (inIndex >= 0 && inIndex < mPrograms.size())
+        {
+            return mPrograms[inIndex]->mName;
+        }
         return juce::String::empty;
-        (void)inIndex;
     }
 
-    template<unsigned NumParameters, class PortsType, class StateType, class MappersType>
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
     void Processor<NumParameters, PortsType, StateType, MappersType>::changeProgramName(int inIndex,
                                                                                         const juce::String& inName)
     {
-        (void)inIndex;
-        (void)inName;
+        jassert(juce::MessageManager::getInstance()->isThisTheMessageThread());
+        jassert(inIndex >= 0 && inIndex < mPrograms.size());
+        if (inIndex >= 0 && inIndex < mPrograms.size())
+        {
+            mPrograms[inIndex]->mName = inName;
+        }
+    }
+
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
+    int Processor<NumParameters, PortsType, StateType, MappersType>::setPrograms(const juce::StringArray& inNames,
+                                                                                 const juce::Array<juce::MemoryBlock>& inStates)
+    {
+        jassert(juce::MessageManager::getInstance()->isThisTheMessageThread());
+        juce::OwnedArray<Program> programs;
+        for (int p = 0; p < inStates.size(); ++p)
+        {
+            const juce::MemoryBlock& data = inStates.getReference(p);
+            const State& state = *reinterpret_cast<const State*>(data.getData());
+            if (data.getSize() != sizeof(State) || state.mMagic != gStateMagic || state.mVersion != gStateVersion)
+            {
+                continue;
+            }
+
+            Program* program = new Program;
+            program->mName = p < inNames.size() ? inNames[p] : juce::String(p + 1);
+            std::copy(state.mParameterValues, state.mParameterValues + NumParameters, program->mParameterValues);
+            mParametersInfo.getPlainValues(program->mParameterValues, program->mPlainValues);
+            program->mTailLengthSeconds = 0.;
+            programs.add(program);
+        }
+
+        // The previous bank is freed once processing has resumed
+        suspendProcessing(true);
+        mPrograms.swapWith(programs);
+        mCurrentProgram = 0;
+        mPendingProgram.set(-1);
+        mapPrograms();
+        suspendProcessing(false);
+
+        updateHostDisplay();
+        return mPrograms.size();
     }
 
     // -------------------------------------------------------------------------
 
-    template<unsigned NumParameters, class PortsType, class StateType, class MappersType>
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
     void Processor<NumParameters, PortsType, StateType, MappersType>::prepareToPlay(double inSamplerate,
                                                                                     int inBlockSize)
     {
-        mContext.mState.mSamplerate = inSamplerate;
-        resetState(mContext.mState);
+        mContext.mFloatState.mSamplerate    = inSamplerate;
+        mContext.mDoubleState.mSamplerate   = inSamplerate;
+        jassert(getNumInputChannels() <= int(gNumMaxChannels) && getNumOutputChannels() <= int(gNumMaxChannels));
+
+        const int numChannels   = std::max(getNumInputChannels(), getNumOutputChannels());
+        const int numTasks      = (numChannels + mNumChannelsPerTask - 1) / mNumChannelsPerTask;
+        const int numWorkers    = std::min(mNumWorkers, numTasks - 1);
+        if (numWorkers > 0 && (mWorkers == 0 || mWorkers->getNumWorkers() != numWorkers))
+        {
+            mWorkers = new WorkerPool(numWorkers);
+        }
+        else if (numWorkers <= 0)
+        {
+            mWorkers = 0;
+        }
+        if (mWorkers != 0)
+        {
+            mWorkers->setMinWork(mMinWork);
+        }
+        mContext.mFloatState.mWorkers       = mWorkers;
+        mContext.mDoubleState.mWorkers      = mWorkers;
+
+        mOversampling                        = isNonRealtime() ? dsp::Oversampler::factor(inSamplerate,
+                                                                                           mMinProcessSamplerate)
+                                                                   : 1;
+        mContext.mFloatState.mOversampling   = mOversampling;
+        mContext.mDoubleState.mOversampling  = mOversampling;
+        mContext.mFloatState.mMaxNumSamples  = inBlockSize;
+        mContext.mDoubleState.mMaxNumSamples = inBlockSize;
+        setLatencySamples(dsp::Oversampler::latency(mOversampling));
+
+        resetState(mContext.mFloatState);
+        resetState(mContext.mDoubleState);
+        mSampleTime = 0;
+        mContext.mEvents.clear();
+        mPendingProgram.set(-1);
         mapAllParameters();
-        (void)inBlockSize;
+        mapPrograms();
     }
 
-    template<unsigned NumParameters, class PortsType, class StateType, class MappersType>
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
     void Processor<NumParameters, PortsType, StateType, MappersType>::releaseResources()
     {
-        mContext.mState.mSamplerate = 0.;
+        mContext.mFloatState.mSamplerate    = 0.;
+        mContext.mDoubleState.mSamplerate   = 0.;
+        mContext.mFloatState.mWorkers       = 0;
+        mContext.mDoubleState.mWorkers      = 0;
+        mWorkers                            = 0;
     }
 
-    template<unsigned NumParameters, class PortsType, class StateType, class MappersType>
-    void Processor<NumParameters, PortsType, StateType, MappersType>::processBlock(juce::AudioSampleBuffer& ioAudioBuffer,
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
+    void Processor<NumParameters, PortsType, StateType, MappersType>::processBlock(juce::AudioBuffer<float>& ioAudioBuffer,
                                                                                    juce::MidiBuffer& ioMidiBuffer)
     {
-        processState(ioAudioBuffer.getArrayOfReadPointers(), ioAudioBuffer.getNumChannels(),
-                     ioAudioBuffer.getArrayOfWritePointers(), ioAudioBuffer.getNumChannels(),
-                     ioAudioBuffer.getNumSamples(), mContext.mPorts.cacheCurrent(),
-                     mContext.mState);
+        processAudioBuffer(ioAudioBuffer, mContext.mFloatState);
         (void)ioMidiBuffer;
     }
 
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
+    void Processor<NumParameters, PortsType, StateType, MappersType>::processBlock(juce::AudioBuffer<double>& ioAudioBuffer,
+                                                                                   juce::MidiBuffer& ioMidiBuffer)
+    {
+        processAudioBuffer(ioAudioBuffer, mContext.mDoubleState);
+        (void)ioMidiBuffer;
+    }
+
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
+    bool Processor<NumParameters, PortsType, StateType, MappersType>::supportsDoublePrecisionProcessing() const
+    {
+        return true;
+    }
+
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
+    template<typename SampleType>
+    void Processor<NumParameters, PortsType, StateType, MappersType>::processAudioBuffer(juce::AudioBuffer<SampleType>& ioAudioBuffer,
+                                                                                         StateType<SampleType>& ioState)
+    {
+        // Channels beyond what the States are sized for are left silent
+        const int numChannels = std::min(ioAudioBuffer.getNumChannels(), int(gNumMaxChannels));
+        for (int c = numChannels; c < ioAudioBuffer.getNumChannels(); ++c)
+        {
+            ioAudioBuffer.clear(c, 0, ioAudioBuffer.getNumSamples());
+        }
+
+        applyPendingProgram();
+        mapDirtyParameters();
+
+        // Split at the scheduled events, applying the ones closer than a sub block together
+        const dsp::ScopedNoDenormals noDenormals;
+        SampleType*const* channels  = ioAudioBuffer.getArrayOfWritePointers();
+        const juce::int64 end       = mSampleTime + ioAudioBuffer.getNumSamples();
+        juce::int64 subBlockStart   = mSampleTime;
+        while (subBlockStart < end)
+        {
+            applyEvents(subBlockStart);
+
+            juce::int64 subBlockEnd = end;
+            if (const ParameterEvent* next = mContext.mEvents.front())
+            {
+                subBlockEnd = juce::jlimit(std::min(subBlockStart + gMinNumSubBlockSamples, end), end,
+                                           next->mSampleTime);
+            }
+
+            const int offset = int(subBlockStart - mSampleTime);
+            SampleType* subBlockChannels[gNumMaxChannels];
+            for (int c = 0; c < numChannels; ++c)
+            {
+                subBlockChannels[c] = channels[c] + offset;
+            }
+            processState(subBlockChannels, numChannels, subBlockChannels, numChannels,
+                         int(subBlockEnd - subBlockStart), mContext.mBlockPorts, ioState);
+            subBlockStart = subBlockEnd;
+        }
+        mSampleTime = end;
+    }
+
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
+    void Processor<NumParameters, PortsType, StateType, MappersType>::applyEvents(juce::int64 inSampleTime)
+    {
+        bool applied = false;
+        for (const ParameterEvent* event = mContext.mEvents.front();
+             event != 0 && event->mSampleTime <= inSampleTime;
+             event = mContext.mEvents.front())
+        {
+            // Mapped from the plain values of the other parameters as they are now
+            const int index                         = event->mIndex;
+            const parameters::ParameterInfo& info   = mParametersInfo[index];
+            unsigned char* port                     = (unsigned char*)&mContext.mBlockPorts + info.mPortId;
+            mPlainValues[index]                     = mParametersInfo.mTapers[index].getPlain(event->mValue);
+            mMappedValues[index]                    = event->mValue;
+            (reinterpret_cast<MappersType*>(this)->*mMappers[mPortIndices[index]])(port);
+            mContext.mEvents.pop();
+            applied = true;
+        }
+        if (applied)
+        {
+            updateTailLength();
+        }
+    }
+
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
+    void Processor<NumParameters, PortsType, StateType, MappersType>::applyPendingProgram()
+    {
+        const int index = mPendingProgram.exchange(-1);
+        if (index < 0)
+        {
+            return;
+        }
+
+        // The events scheduled for the previous program would override it
+        const Program& program = *mPrograms[index];
+        mContext.mEvents.clear();
+        mContext.mBlockPorts = program.mPorts;
+        std::copy(program.mParameterValues, program.mParameterValues + NumParameters, mMappedValues);
+        std::copy(program.mPlainValues, program.mPlainValues + NumParameters, mPlainValues);
+        mTailLengthSeconds.set(program.mTailLengthSeconds);
+    }
+
     // -------------------------------------------------------------------------
 
-    template<unsigned NumParameters, class PortsType, class StateType, class MappersType>
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
     void Processor<NumParameters, PortsType, StateType, MappersType>::getStateInformation(juce::MemoryBlock& outData)
     {
         jassert(juce::MessageManager::getInstance()->isThisTheMessageThread());
@@ -239,7 +477,7 @@ namespace plugin
         outData.append(&mState, sizeof(State));
     }
 
-    template<unsigned NumParameters, class PortsType, class StateType, class MappersType>
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
     void Processor<NumParameters, PortsType, StateType, MappersType>::setStateInformation(const void* inData,
                                                                                           int inDataSize)
     {
@@ -253,53 +491,183 @@ namespace plugin
         if (state.mMagic == gStateMagic && state.mVersion == gStateVersion)
         {
             mState = state;
-            mapAllParameters();
+            mDirtyParameters.setAll();
         }
     }
 
     // -------------------------------------------------------------------------
 
-    template<unsigned NumParameters, class PortsType, class StateType, class MappersType>
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
+    void Processor<NumParameters, PortsType, StateType, MappersType>::mapDirtyParameters()
+    {
+        juce::uint32 dirtyParameters[DirtyFlags<NumParameters>::numWords];
+        if (!mDirtyParameters.take(dirtyParameters))
+        {
+            return;
+        }
+
+        // Hosts resend unchanged values, and presets change a few parameters at most
+        bool changed[NumParameters] = { false };
+        bool dirtyPorts[NumParameters] = { false };
+        unsigned numChanged = 0;
+        for (unsigned i = 0; i < NumParameters; ++i)
+        {
+            const float value = mState.mParameterValues[i];
+            if (DirtyFlags<NumParameters>::isSet(dirtyParameters, i) && value != mMappedValues[i])
+            {
+                mMappedValues[i]            = value;
+                changed[i]                  = true;
+                dirtyPorts[mPortIndices[i]] = true;
+                ++numChanged;
+            }
+        }
+        if (numChanged == 0)
+        {
+            return;
+        }
+
+        // Automation changes a parameter or two, cheaper to convert alone than all at once
+        if (4 * numChanged > NumParameters)
+        {
+            mParametersInfo.getPlainValues(mState.mParameterValues, mPlainValues);
+        }
+        else
+        {
+            for (unsigned i = 0; i < NumParameters; ++i)
+            {
+                if (changed[i])
+                {
+                    mPlainValues[i] = mParametersInfo.mTapers[i].getPlain(mMappedValues[i]);
+                }
+            }
+        }
+
+        for (unsigned i = 0; i < NumParameters; ++i)
+        {
+            if (dirtyPorts[i])
+            {
+                mapPort(i);
+            }
+        }
+        updateTailLength();
+    }
+
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
     void Processor<NumParameters, PortsType, StateType, MappersType>::mapAllParameters()
     {
-        jassert(mContext.mState.mSamplerate > 0.);
-        for (int i = 0; i < int(NumParameters); ++i)
+        jassert(mContext.mFloatState.mSamplerate > 0.);
+        juce::uint32 dirtyParameters[DirtyFlags<NumParameters>::numWords];
+        mDirtyParameters.take(dirtyParameters);
+
+        mParametersInfo.getPlainValues(mState.mParameterValues, mPlainValues);
+        for (unsigned i = 0; i < NumParameters; ++i)
         {
-            jassert(mMappers[i] != 0);
-            (reinterpret_cast<MappersType*>(this)->*mMappers[i])((unsigned char*)mContext.mPorts.pending() +
-                                                                 mParametersInfo[i].mPortId);
+            mMappedValues[i] = mState.mParameterValues[i];
+            if (mPortIndices[i] == i)
+            {
+                mapPort(i);
+            }
         }
-        mContext.mPorts.swapAndCopy();
+        updateTailLength();
+    }
+
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
+    void Processor<NumParameters, PortsType, StateType, MappersType>::mapPort(unsigned inPortIndex)
+    {
+        jassert(mMappers[inPortIndex] != 0);
+        (reinterpret_cast<MappersType*>(this)->*mMappers[inPortIndex])((unsigned char*)&mContext.mBlockPorts +
+                                                                       mParametersInfo[inPortIndex].mPortId);
     }
 
-    template<unsigned NumParameters, class PortsType, class StateType, class MappersType>
-    void Processor<NumParameters, PortsType, StateType, MappersType>::mapParameter(int inIndex)
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
+    void Processor<NumParameters, PortsType, StateType, MappersType>::updateTailLength()
     {
-        jassert(inIndex < int(NumParameters) && mMappers[inIndex] != 0);
-        (reinterpret_cast<MappersType*>(this)->*mMappers[inIndex])((unsigned char*)mContext.mPorts.pending() +
-                                                                   mParametersInfo[inIndex].mPortId);
-        mContext.mPorts.swapAndCopy();
+        mTailLengthSeconds.set(tailLengthSeconds(mContext.mBlockPorts, getProcessSamplerate()));
+    }
+
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
+    void Processor<NumParameters, PortsType, StateType, MappersType>::mapPrograms()
+    {
+        // Until prepareToPlay, which maps them
+        if (mContext.mFloatState.mSamplerate <= 0.)
+        {
+            return;
+        }
+
+        // The mappers read mPlainValues, set to each program's in turn, then back to the mapped ones
+        for (int p = 0; p < mPrograms.size(); ++p)
+        {
+            Program& program = *mPrograms[p];
+            std::copy(program.mPlainValues, program.mPlainValues + NumParameters, mPlainValues);
+            for (unsigned i = 0; i < NumParameters; ++i)
+            {
+                if (mPortIndices[i] == i)
+                {
+                    jassert(mMappers[i] != 0);
+                    (reinterpret_cast<MappersType*>(this)->*mMappers[i])((unsigned char*)&program.mPorts +
+                                                                         mParametersInfo[i].mPortId);
+                }
+            }
+            program.mTailLengthSeconds = tailLengthSeconds(program.mPorts, getProcessSamplerate());
+        }
+        mParametersInfo.getPlainValues(mMappedValues, mPlainValues);
     }
 
     // -------------------------------------------------------------------------
 
-    template<unsigned NumParameters, class PortsType, class StateType, class MappersType>
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
     void Processor<NumParameters, PortsType, StateType, MappersType>::setMapper(int inIndex,
                                                                                 void (MappersType::*inMapper)(void*))
     {
+        // A port is mapped once, by the mapper of its first parameter
+        jassert(mPortIndices[inIndex] == unsigned(inIndex) || mMappers[mPortIndices[inIndex]] == inMapper);
         mMappers[inIndex] = inMapper;
     }
 
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
+    void Processor<NumParameters, PortsType, StateType, MappersType>::enableWorkers(int inNumWorkers,
+                                                                                     int inNumChannelsPerTask,
+                                                                                     int inMinWork)
+    {
+        jassert(juce::MessageManager::getInstance()->isThisTheMessageThread() && inNumChannelsPerTask > 0);
+        mNumWorkers         = std::max(inNumWorkers, 0);
+        mNumChannelsPerTask = std::max(inNumChannelsPerTask, 1);
+        mMinWork            = std::max(inMinWork, 0);
+    }
+
+    /*!
+        Overrides enableWorkers, whether the subclass constructor called it or not.
+    */
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
+    void Processor<NumParameters, PortsType, StateType, MappersType>::disableWorkers()
+    {
+        jassert(juce::MessageManager::getInstance()->isThisTheMessageThread());
+        mNumWorkers = 0;
+    }
+
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
+    void Processor<NumParameters, PortsType, StateType, MappersType>::enableOversampling(double inMinSamplerate)
+    {
+        jassert(juce::MessageManager::getInstance()->isThisTheMessageThread());
+        mMinProcessSamplerate = inMinSamplerate;
+    }
+
     // -------------------------------------------------------------------------
 
-    template<unsigned NumParameters, class PortsType, class StateType, class MappersType>
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
     inline float Processor<NumParameters, PortsType, StateType, MappersType>::getParameterPlain(int inIndex)
     {
         jassert(inIndex < int(NumParameters));
         if (inIndex < int(NumParameters))
         {
-            return mParametersInfo[inIndex].mTaper->getPlain(mState.mParameterValues[inIndex]);
+            return mPlainValues[inIndex];
         }
         return 0.f;
     }
+
+    template<unsigned NumParameters, class PortsType, template<typename> class StateType, class MappersType>
+    inline double Processor<NumParameters, PortsType, StateType, MappersType>::getProcessSamplerate() const
+    {
+        return getSampleRate() * mOversampling;
+    }
 }
@@ -0,0 +1,11 @@
+/*!
+ * \file       framework_Reference.cpp
+ * Copyright   Eiosis 2014
+ */
+
+#include "framework/framework_Reference.h"
+
+namespace dsp
+{
+
+}
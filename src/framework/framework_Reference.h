@@ -0,0 +1,69 @@
+/*!
+ * \file       framework_Reference.h
+ * Copyright   Eiosis 2014
+ */
+
+#pragma once
+
+#include "framework/framework_Cells.h"
+
+namespace dsp
+{
+    /*
+        Reference cells are the plain scalar forms of the cells, one sample and one channel at a time,
+        on the same Ports and States. They are the ground truth the optimized cells (SIMD lanes,
+        fused cascades, time-parallel forms) are checked against, run in float64, and are not meant to be fast:
+        keep them as simple as the algorithm allows, and change them only when the algorithm changes.
+    */
+    namespace reference
+    {
+        /*!
+            One decay step per sample towards the target,
+            a gain within 1e-9 of its target at the start of a block being snapped to it.
+        */
+        struct Gain
+        {
+            template<typename SampleType>
+            static inline void process(const SampleType* inSrc, SampleType* outDest,
+                                       int inNumSamples, const dsp::Gain::Port& inPort,
+                                       dsp::Gain::State<SampleType>& ioState)
+            {
+                const SampleType target = SampleType(inPort.mTargetGain);
+                SampleType gain         = ioState.mCurrentGain;
+                if (std::abs(gain - target) < SampleType(1e-9))
+                {
+                    gain = target;
+                }
+
+                for (int j = 0; j < inNumSamples; ++j)
+                {
+                    gain        = target + (gain - target) * ioState.mDecay;
+                    outDest[j]  = inSrc[j] * gain;
+                }
+                ioState.mCurrentGain = gain;
+            }
+        };
+
+        /*!
+            The transposed direct form II biquad.
+        */
+        struct IIR
+        {
+            template<typename SampleType>
+            static inline void process(const SampleType* inSrc, SampleType* outDest,
+                                       int inNumSamples, const dsp::IIR::Port& inPort,
+                                       dsp::IIR::State<SampleType>& ioState)
+            {
+                const float64* c = inPort.mCoefficients;
+                for (int j = 0; j < inNumSamples; ++j)
+                {
+                    const SampleType in     = inSrc[j];
+                    const SampleType out    = SampleType(c[0]) * in + ioState.mX;
+                    ioState.mX              = SampleType(c[1]) * in - SampleType(c[4]) * out + ioState.mY;
+                    ioState.mY              = SampleType(c[2]) * in - SampleType(c[5]) * out;
+                    outDest[j]              = out;
+                }
+            }
+        };
+    }
+}
@@ -0,0 +1,11 @@
+/*!
+ * \file       framework_SIMD.cpp
+ * Copyright   Eiosis 2014
+ */
+
+#include "framework/framework_SIMD.h"
+
+namespace dsp
+{
+
+}
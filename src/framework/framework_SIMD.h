@@ -0,0 +1,296 @@
+/*!
+ * \file       framework_SIMD.h
+ * Copyright   Eiosis 2014
+ */
+
+#pragma once
+
+#include "framework/framework_DSP.h"
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define DSP_USE_SSE 1
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define DSP_USE_NEON 1
+    #include <arm_neon.h>
+#endif
+
+namespace dsp
+{
+    /*!
+        The simd namespace wraps 4 lanes float32 and float64 vector types and the few operations
+        the cells need, so that cells are written once for SSE, NEON and plain C++,
+        and for both sample types. Vector<SampleType>::Type gives the vector type of a sample type.
+        All loads and stores are unaligned.
+    */
+    namespace simd
+    {
+        enum { numLanes = 4 };
+
+        /*!
+            Plain C++ vector, used where no instruction set is available.
+        */
+        template<typename Type>
+        struct Generic4
+        {
+            Type mValues[numLanes];
+        };
+
+        template<typename Type>
+        inline Generic4<Type> load(const Type* inSrc)
+        {
+            Generic4<Type> res;
+            for (int i = 0; i < numLanes; ++i) res.mValues[i] = inSrc[i];
+            return res;
+        }
+        template<typename Type>
+        inline void store(Type* outDest, const Generic4<Type>& inValue)
+        {
+            for (int i = 0; i < numLanes; ++i) outDest[i] = inValue.mValues[i];
+        }
+        template<typename Type>
+        inline Generic4<Type> set(Type inValue)
+        {
+            Generic4<Type> res;
+            for (int i = 0; i < numLanes; ++i) res.mValues[i] = inValue;
+            return res;
+        }
+        template<typename Type>
+        inline Generic4<Type> add(Generic4<Type> inA, const Generic4<Type>& inB)
+        {
+            for (int i = 0; i < numLanes; ++i) inA.mValues[i] += inB.mValues[i];
+            return inA;
+        }
+        template<typename Type>
+        inline Generic4<Type> sub(Generic4<Type> inA, const Generic4<Type>& inB)
+        {
+            for (int i = 0; i < numLanes; ++i) inA.mValues[i] -= inB.mValues[i];
+            return inA;
+        }
+        template<typename Type>
+        inline Generic4<Type> mul(Generic4<Type> inA, const Generic4<Type>& inB)
+        {
+            for (int i = 0; i < numLanes; ++i) inA.mValues[i] *= inB.mValues[i];
+            return inA;
+        }
+
+        template<int Lane, typename Type>
+        inline Generic4<Type> broadcast(const Generic4<Type>& inValue)
+        {
+            return set(inValue.mValues[Lane]);
+        }
+
+        template<typename Type>
+        inline void transpose(Generic4<Type>& ioA, Generic4<Type>& ioB,
+                              Generic4<Type>& ioC, Generic4<Type>& ioD)
+        {
+            Generic4<Type>* rows[numLanes] = { &ioA, &ioB, &ioC, &ioD };
+            for (int i = 0; i < numLanes; ++i)
+            {
+                for (int j = i + 1; j < numLanes; ++j)
+                {
+                    std::swap(rows[i]->mValues[j], rows[j]->mValues[i]);
+                }
+            }
+        }
+
+        // ---------------------------------------------------------------------
+
+#if DSP_USE_SSE
+        typedef __m128 Float4;
+
+        inline Float4 load(const float32* inSrc)            { return _mm_loadu_ps(inSrc); }
+        inline void store(float32* outDest, Float4 inValue) { _mm_storeu_ps(outDest, inValue); }
+        inline Float4 set(float32 inValue)                  { return _mm_set1_ps(inValue); }
+        inline Float4 add(Float4 inA, Float4 inB)           { return _mm_add_ps(inA, inB); }
+        inline Float4 sub(Float4 inA, Float4 inB)           { return _mm_sub_ps(inA, inB); }
+        inline Float4 mul(Float4 inA, Float4 inB)           { return _mm_mul_ps(inA, inB); }
+
+        template<int Lane>
+        inline Float4 broadcast(Float4 inValue)
+        {
+            return _mm_shuffle_ps(inValue, inValue, _MM_SHUFFLE(Lane, Lane, Lane, Lane));
+        }
+
+        inline void transpose(Float4& ioA, Float4& ioB, Float4& ioC, Float4& ioD)
+        {
+            _MM_TRANSPOSE4_PS(ioA, ioB, ioC, ioD);
+        }
+
+        /*!
+            SSE2 float64 vector, as a pair of 2 lanes registers.
+        */
+        struct Double4
+        {
+            __m128d mLow;
+            __m128d mHigh;
+        };
+
+        inline Double4 load(const float64* inSrc)
+        {
+            const Double4 res = { _mm_loadu_pd(inSrc), _mm_loadu_pd(inSrc + 2) };
+            return res;
+        }
+        inline void store(float64* outDest, const Double4& inValue)
+        {
+            _mm_storeu_pd(outDest, inValue.mLow);
+            _mm_storeu_pd(outDest + 2, inValue.mHigh);
+        }
+        inline Double4 set(float64 inValue)
+        {
+            const Double4 res = { _mm_set1_pd(inValue), _mm_set1_pd(inValue) };
+            return res;
+        }
+        inline Double4 add(const Double4& inA, const Double4& inB)
+        {
+            const Double4 res = { _mm_add_pd(inA.mLow, inB.mLow), _mm_add_pd(inA.mHigh, inB.mHigh) };
+            return res;
+        }
+        inline Double4 sub(const Double4& inA, const Double4& inB)
+        {
+            const Double4 res = { _mm_sub_pd(inA.mLow, inB.mLow), _mm_sub_pd(inA.mHigh, inB.mHigh) };
+            return res;
+        }
+        inline Double4 mul(const Double4& inA, const Double4& inB)
+        {
+            const Double4 res = { _mm_mul_pd(inA.mLow, inB.mLow), _mm_mul_pd(inA.mHigh, inB.mHigh) };
+            return res;
+        }
+
+        template<int Lane>
+        inline Double4 broadcast(const Double4& inValue)
+        {
+            const __m128d half      = Lane < 2 ? inValue.mLow : inValue.mHigh;
+            const __m128d value     = _mm_shuffle_pd(half, half, (Lane & 1) * 3);
+            const Double4 res       = { value, value };
+            return res;
+        }
+
+        inline void transpose(Double4& ioA, Double4& ioB, Double4& ioC, Double4& ioD)
+        {
+            const Double4 a = ioA, b = ioB, c = ioC, d = ioD;
+            ioA.mLow    = _mm_unpacklo_pd(a.mLow, b.mLow);
+            ioA.mHigh   = _mm_unpacklo_pd(c.mLow, d.mLow);
+            ioB.mLow    = _mm_unpackhi_pd(a.mLow, b.mLow);
+            ioB.mHigh   = _mm_unpackhi_pd(c.mLow, d.mLow);
+            ioC.mLow    = _mm_unpacklo_pd(a.mHigh, b.mHigh);
+            ioC.mHigh   = _mm_unpacklo_pd(c.mHigh, d.mHigh);
+            ioD.mLow    = _mm_unpackhi_pd(a.mHigh, b.mHigh);
+            ioD.mHigh   = _mm_unpackhi_pd(c.mHigh, d.mHigh);
+        }
+#elif DSP_USE_NEON
+        typedef float32x4_t Float4;
+
+        inline Float4 load(const float32* inSrc)            { return vld1q_f32(inSrc); }
+        inline void store(float32* outDest, Float4 inValue) { vst1q_f32(outDest, inValue); }
+        inline Float4 set(float32 inValue)                  { return vdupq_n_f32(inValue); }
+        inline Float4 add(Float4 inA, Float4 inB)           { return vaddq_f32(inA, inB); }
+        inline Float4 sub(Float4 inA, Float4 inB)           { return vsubq_f32(inA, inB); }
+        inline Float4 mul(Float4 inA, Float4 inB)           { return vmulq_f32(inA, inB); }
+
+        template<int Lane>
+        inline Float4 broadcast(Float4 inValue)
+        {
+            return vdupq_n_f32(vgetq_lane_f32(inValue, Lane));
+        }
+
+        inline void transpose(Float4& ioA, Float4& ioB, Float4& ioC, Float4& ioD)
+        {
+            const float32x4x2_t ab = vtrnq_f32(ioA, ioB);
+            const float32x4x2_t cd = vtrnq_f32(ioC, ioD);
+            ioA = vcombine_f32(vget_low_f32(ab.val[0]), vget_low_f32(cd.val[0]));
+            ioB = vcombine_f32(vget_low_f32(ab.val[1]), vget_low_f32(cd.val[1]));
+            ioC = vcombine_f32(vget_high_f32(ab.val[0]), vget_high_f32(cd.val[0]));
+            ioD = vcombine_f32(vget_high_f32(ab.val[1]), vget_high_f32(cd.val[1]));
+        }
+
+        typedef Generic4<float64> Double4;
+#else
+        typedef Generic4<float32> Float4;
+        typedef Generic4<float64> Double4;
+#endif
+
+        // ---------------------------------------------------------------------
+
+        template<typename SampleType>
+        struct Vector;
+
+        template<>
+        struct Vector<float32>
+        {
+            typedef Float4 Type;
+        };
+
+        template<>
+        struct Vector<float64>
+        {
+            typedef Double4 Type;
+        };
+    }
+
+    // -------------------------------------------------------------------------
+
+    /*!
+        ScopedNoDenormals sets the floating point unit to flush denormal results
+        and operands to zero for its lifetime, and restores the previous mode on destruction.
+        It is meant to wrap whole process calls, so that cells do not have to
+        check for denormals themselves: x86 sets MXCSR FTZ and DAZ,
+        ARM sets the FZ bit of FPCR (AArch64) or FPSCR (ARMv7, which flushes inputs as well).
+        Elsewhere it does nothing.
+    */
+    class ScopedNoDenormals
+    {
+    public:
+#if DSP_USE_SSE
+        enum { flushToZero = 0x8000, denormalsAreZero = 0x0040 };
+
+        ScopedNoDenormals()
+            : mPreviousMode(_mm_getcsr())
+        {
+            _mm_setcsr(mPreviousMode | flushToZero | denormalsAreZero);
+        }
+        ~ScopedNoDenormals()
+        {
+            _mm_setcsr(mPreviousMode);
+        }
+
+    private:
+        const unsigned int mPreviousMode;
+#elif DSP_USE_NEON && defined(__GNUC__) && (defined(__aarch64__) || defined(__arm__))
+        enum { flushToZero = 1 << 24 };
+
+        ScopedNoDenormals()
+            : mPreviousMode(getMode())
+        {
+            setMode(mPreviousMode | flushToZero);
+        }
+        ~ScopedNoDenormals()
+        {
+            setMode(mPreviousMode);
+        }
+
+    private:
+    #if defined(__aarch64__)
+        typedef unsigned long long Mode;
+
+        static inline Mode getMode()                { Mode mode; __asm__ __volatile__("mrs %0, fpcr" : "=r"(mode)); return mode; }
+        static inline void setMode(Mode inMode)     { __asm__ __volatile__("msr fpcr, %0" : : "r"(inMode)); }
+    #else
+        typedef unsigned int Mode;
+
+        static inline Mode getMode()                { Mode mode; __asm__ __volatile__("vmrs %0, fpscr" : "=r"(mode)); return mode; }
+        static inline void setMode(Mode inMode)     { __asm__ __volatile__("vmsr fpscr, %0" : : "r"(inMode)); }
+    #endif
+
+    private:
+        const Mode mPreviousMode;
+#else
+        ScopedNoDenormals() {}
+#endif
+
+    private:
+        ScopedNoDenormals(const ScopedNoDenormals&);
+        ScopedNoDenormals& operator=(const ScopedNoDenormals&);
+    };
+}
@@ -0,0 +1,454 @@
+/*!
+ * \file       framework_Workers.cpp
+ * Copyright   Eiosis 2014
+ */
+
+#include "framework/framework_Workers.h"
+
+#if JUCE_WINDOWS
+    #include <climits>
+    #include <windows.h>
+#elif JUCE_MAC || JUCE_IOS
+    #include <dispatch/dispatch.h>
+#else
+    #include <semaphore.h>
+#endif
+
+namespace plugin
+{
+    inline void spinPause()
+    {
+#if DSP_USE_SSE
+        _mm_pause();
+#endif
+    }
+
+    inline int claimGeneration(int inClaim)
+    {
+        return inClaim >> 16;
+    }
+
+    // -------------------------------------------------------------------------
+
+    /*!
+        Semaphore parks a worker until the audio thread posts to it.
+        Unlike juce::WaitableEvent, which locks a mutex to signal, posting takes no lock
+        (a futex on Linux, a dispatch semaphore on macOS), and wake() only posts to parked workers.
+    */
+    class Semaphore
+    {
+    public:
+#if JUCE_WINDOWS
+        Semaphore()             : mHandle(CreateSemaphore(0, 0, LONG_MAX, 0))   {}
+        ~Semaphore()            { CloseHandle(mHandle); }
+        inline void post()      { ReleaseSemaphore(mHandle, 1, 0); }
+        inline void wait()      { WaitForSingleObject(mHandle, INFINITE); }
+    private:
+        HANDLE mHandle;
+#elif JUCE_MAC || JUCE_IOS
+        Semaphore()             : mSemaphore(dispatch_semaphore_create(0))      {}
+        ~Semaphore()            { dispatch_release(mSemaphore); }
+        inline void post()      { dispatch_semaphore_signal(mSemaphore); }
+        inline void wait()      { dispatch_semaphore_wait(mSemaphore, DISPATCH_TIME_FOREVER); }
+    private:
+        dispatch_semaphore_t mSemaphore;
+#else
+        Semaphore()             { sem_init(&mSemaphore, 0, 0); }
+        ~Semaphore()            { sem_destroy(&mSemaphore); }
+        inline void post()      { sem_post(&mSemaphore); }
+        inline void wait()      { while (sem_wait(&mSemaphore) != 0) {} }
+    private:
+        sem_t mSemaphore;
+#endif
+
+    private:
+        JUCE_DECLARE_NON_COPYABLE(Semaphore);
+    };
+
+    // -------------------------------------------------------------------------
+
+    class WorkerPool::Worker : public juce::Thread
+    {
+    public:
+        Worker(WorkerPool& inPool, int inIndex)
+            : juce::Thread("WorkerPool " + juce::String(inIndex))
+            , mPool(inPool)
+        {
+            mParked.set(0);
+        }
+
+    public: // juce::Thread
+        virtual void run()
+        {
+            // The flags are per thread, and tasks expect the ones of the audio thread
+            const dsp::ScopedNoDenormals noDenormals;
+            int generation = claimGeneration(mPool.mClaim.get());
+            while (!threadShouldExit())
+            {
+                int spins = 0;
+                while (claimGeneration(mPool.mClaim.get()) == generation && spins < mPool.mNumSpins)
+                {
+                    spinPause();
+                    ++spins;
+                }
+
+                if (claimGeneration(mPool.mClaim.get()) == generation)
+                {
+                    // The batch may have been published between the last check and parking,
+                    // in which case wake() has seen mParked set and posts to the semaphore.
+                    // A post left over from a previous batch only costs one more spin.
+                    mParked.set(1);
+                    if (claimGeneration(mPool.mClaim.get()) == generation && !threadShouldExit())
+                    {
+                        mWakeUp.wait();
+                    }
+                    mParked.set(0);
+                    continue;
+                }
+
+                generation = claimGeneration(mPool.mClaim.get());
+                while (mPool.runNextTask())
+                {
+                }
+            }
+        }
+
+    public:
+        inline void wake()
+        {
+            if (mParked.get() != 0)
+            {
+                mWakeUp.post();
+            }
+        }
+        void stop()
+        {
+            signalThreadShouldExit();
+            mWakeUp.post();
+            stopThread(-1);
+        }
+
+    private:
+        WorkerPool& mPool;
+        Semaphore mWakeUp;
+        juce::Atomic<int> mParked;
+
+    private:
+        JUCE_DECLARE_NON_COPYABLE(Worker);
+    };
+
+    // -------------------------------------------------------------------------
+
+    WorkerPool::WorkerPool(int inNumWorkers, int inNumSpins)
+        : mNumSpins(inNumSpins)
+        , mMinWork(defaultMinWork)
+        , mTask(0)
+        , mContext(0)
+    {
+        mClaim.set(0);
+        mNumDone.set(0);
+
+        for (int i = 0; i < inNumWorkers; ++i)
+        {
+            mWorkers.add(new Worker(*this, i));
+        }
+        for (int i = 0; i < mWorkers.size(); ++i)
+        {
+            mWorkers[i]->startThread(10);
+        }
+    }
+
+    WorkerPool::~WorkerPool()
+    {
+        for (int i = 0; i < mWorkers.size(); ++i)
+        {
+            mWorkers[i]->stop();
+        }
+    }
+
+    // -------------------------------------------------------------------------
+
+    int WorkerPool::getNumWorkers() const
+    {
+        return mWorkers.size();
+    }
+
+    void WorkerPool::setMinWork(int inMinWork)
+    {
+        mMinWork = inMinWork;
+    }
+
+    bool WorkerPool::isWorthSplitting(int inNumTasks, int inWork) const
+    {
+        return mWorkers.size() > 0 && inNumTasks > 1 && inWork >= mMinWork;
+    }
+
+    // -------------------------------------------------------------------------
+
+    void WorkerPool::run(Task inTask, void* inContext, int inNumTasks)
+    {
+        jassert(inNumTasks <= int(maxNumTasks));
+
+        mTask       = inTask;
+        mContext    = inContext;
+        mNumDone.set(0);
+
+        const int generation = (claimGeneration(mClaim.get()) + 1) & 0x7fff;
+        mClaim.set((generation << 16) | (inNumTasks << 8));
+
+        for (int i = 0; i < mWorkers.size(); ++i)
+        {
+            mWorkers[i]->wake();
+        }
+
+        while (runNextTask())
+        {
+        }
+        while (mNumDone.get() < inNumTasks)
+        {
+            spinPause();
+        }
+    }
+
+    /*!
+        A task can only be claimed while its batch is running,
+        so that mTask and mContext are still the ones of that batch.
+    */
+    bool WorkerPool::runNextTask()
+    {
+        for (;;)
+        {
+            const int claim     = mClaim.get();
+            const int numTasks  = (claim >> 8) & 0xff;
+            const int index     = claim & 0xff;
+            if (index >= numTasks)
+            {
+                return false;
+            }
+            if (mClaim.compareAndSetBool(claim + 1, claim))
+            {
+                mTask(mContext, index);
+                ++mNumDone;
+                return true;
+            }
+        }
+    }
+
+    // -------------------------------------------------------------------------
+
+    JobQueue::Job::Job(const void* inOwner)
+        : mOwner(inOwner)
+    {}
+
+    JobQueue::Job::~Job()
+    {
+
+    }
+
+    const void* JobQueue::Job::getOwner() const
+    {
+        return mOwner;
+    }
+
+    // -------------------------------------------------------------------------
+
+    class JobQueue::Worker : public juce::Thread
+    {
+    public:
+        Worker(JobQueue& inQueue, int inIndex)
+            : juce::Thread("JobQueue " + juce::String(inIndex))
+            , mQueue(inQueue)
+            , mIndex(inIndex)
+        {}
+
+    public: // juce::Thread
+        virtual void run()
+        {
+            while (!threadShouldExit())
+            {
+                // A job posted since takeNextJob has notified, and wait returns right away
+                Job* job = mQueue.takeNextJob(mIndex);
+                if (job == 0)
+                {
+                    wait(-1);
+                    continue;
+                }
+                job->execute();
+                mQueue.finishJob(mIndex, job);
+            }
+        }
+
+    private:
+        JobQueue& mQueue;
+        const int mIndex;
+
+    private:
+        JUCE_DECLARE_NON_COPYABLE(Worker);
+    };
+
+    // -------------------------------------------------------------------------
+
+    JobQueue::JobQueue()
+        : mFirstPendingJob(0)
+        , mNumPendingJobs(0)
+    {
+        std::fill(mPendingJobs, mPendingJobs + int(maxNumPendingJobs), (Job*)0);
+        std::fill(mRunningJobs, mRunningJobs + int(numWorkers), (Job*)0);
+
+        for (int i = 0; i < int(numWorkers); ++i)
+        {
+            mWorkers.add(new Worker(*this, i));
+        }
+        for (int i = 0; i < mWorkers.size(); ++i)
+        {
+            mWorkers[i]->startThread(4);
+        }
+    }
+
+    JobQueue::~JobQueue()
+    {
+        for (int i = 0; i < mWorkers.size(); ++i)
+        {
+            mWorkers[i]->signalThreadShouldExit();
+            mWorkers[i]->notify();
+        }
+        for (int i = 0; i < mWorkers.size(); ++i)
+        {
+            mWorkers[i]->stopThread(-1);
+        }
+        cancelPendingUpdate();
+
+        for (int j = 0; j < mNumPendingJobs; ++j)
+        {
+            delete mPendingJobs[(mFirstPendingJob + j) % int(maxNumPendingJobs)];
+        }
+        for (int j = 0; j < mFinishedJobs.size(); ++j)
+        {
+            delete mFinishedJobs[j];
+        }
+    }
+
+    // -------------------------------------------------------------------------
+
+    bool JobQueue::post(Job* inJob)
+    {
+        jassert(inJob != 0);
+        {
+            const juce::ScopedLock lock(mLock);
+            if (mNumPendingJobs < int(maxNumPendingJobs))
+            {
+                mPendingJobs[(mFirstPendingJob + mNumPendingJobs) % int(maxNumPendingJobs)] = inJob;
+                ++mNumPendingJobs;
+                inJob = 0;
+            }
+        }
+        if (inJob != 0)
+        {
+            delete inJob;
+            return false;
+        }
+
+        for (int i = 0; i < mWorkers.size(); ++i)
+        {
+            mWorkers[i]->notify();
+        }
+        return true;
+    }
+
+    void JobQueue::cancel(const void* inOwner)
+    {
+        jassert(juce::MessageManager::getInstance()->isThisTheMessageThread());
+        juce::Array<Job*> dropped;
+        bool running = true;
+        while (running)
+        {
+            {
+                const juce::ScopedLock lock(mLock);
+
+                // Compacts the pending jobs left in place, in order
+                int numKept = 0;
+                for (int j = 0; j < mNumPendingJobs; ++j)
+                {
+                    Job* job = mPendingJobs[(mFirstPendingJob + j) % int(maxNumPendingJobs)];
+                    if (job->getOwner() == inOwner)
+                    {
+                        dropped.add(job);
+                        continue;
+                    }
+                    mPendingJobs[(mFirstPendingJob + numKept) % int(maxNumPendingJobs)] = job;
+                    ++numKept;
+                }
+                mNumPendingJobs = numKept;
+
+                for (int j = mFinishedJobs.size(); --j >= 0;)
+                {
+                    if (mFinishedJobs[j]->getOwner() == inOwner)
+                    {
+                        dropped.add(mFinishedJobs[j]);
+                        mFinishedJobs.remove(j);
+                    }
+                }
+
+                running = false;
+                for (int i = 0; i < int(numWorkers); ++i)
+                {
+                    running = running || (mRunningJobs[i] != 0 && mRunningJobs[i]->getOwner() == inOwner);
+                }
+            }
+            if (running)
+            {
+                mJobFinished.wait(-1);
+            }
+        }
+
+        for (int j = 0; j < dropped.size(); ++j)
+        {
+            delete dropped[j];
+        }
+    }
+
+    // -------------------------------------------------------------------------
+
+    void JobQueue::handleAsyncUpdate()
+    {
+        juce::Array<Job*> finished;
+        {
+            const juce::ScopedLock lock(mLock);
+            finished.swapWith(mFinishedJobs);
+        }
+
+        for (int j = 0; j < finished.size(); ++j)
+        {
+            finished[j]->completed();
+            delete finished[j];
+        }
+    }
+
+    // -------------------------------------------------------------------------
+
+    JobQueue::Job* JobQueue::takeNextJob(int inWorker)
+    {
+        const juce::ScopedLock lock(mLock);
+        if (mNumPendingJobs == 0)
+        {
+            return 0;
+        }
+
+        Job* job                    = mPendingJobs[mFirstPendingJob];
+        mFirstPendingJob            = (mFirstPendingJob + 1) % int(maxNumPendingJobs);
+        --mNumPendingJobs;
+        mRunningJobs[inWorker]      = job;
+        return job;
+    }
+
+    void JobQueue::finishJob(int inWorker, Job* inJob)
+    {
+        {
+            const juce::ScopedLock lock(mLock);
+            mRunningJobs[inWorker] = 0;
+            mFinishedJobs.add(inJob);
+        }
+        mJobFinished.signal();
+        triggerAsyncUpdate();
+    }
+}
@@ -0,0 +1,251 @@
+/*!
+ * \file       framework_Workers.h
+ * Copyright   Eiosis 2014
+ */
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "framework/framework_Cells.h"
+
+namespace plugin
+{
+    /*!
+        WorkerPool runs a batch of independent tasks on a few real-time threads
+        and on the calling thread, and returns once all of them are done.
+        It is built for the audio thread: run() does not allocate nor lock.
+        Tasks are claimed through a single atomic word holding the batch generation,
+        its number of tasks and the next task index, so that a worker late on a previous
+        batch can never claim a task of the next one.
+        Between batches workers spin for a while, so that back to back blocks
+        do not pay for a wake up, then park on their own semaphore until the next batch,
+        which the audio thread posts to without taking a lock.
+    */
+    class WorkerPool
+    {
+    public:
+        typedef void (*Task)(void* inContext, int inIndex);
+
+        enum { maxNumTasks = 255, defaultNumSpins = 4096, defaultMinWork = 128 };
+
+    public:
+        explicit WorkerPool(int inNumWorkers, int inNumSpins = defaultNumSpins);
+        ~WorkerPool();
+
+    public:
+        int getNumWorkers() const;
+
+    public:
+        /*!
+            Below inMinWork (channels times samples), a batch is cheaper run serially
+            than split, and isWorthSplitting returns false.
+        */
+        void setMinWork(int inMinWork);
+        bool isWorthSplitting(int inNumTasks, int inWork) const;
+
+    public:
+        /*!
+            Calls inTask(inContext, i) for each i in [0, inNumTasks[, across the workers
+            and the calling thread, and returns when all calls have returned.
+        */
+        void run(Task inTask, void* inContext, int inNumTasks);
+
+    private:
+        class Worker;
+
+    private:
+        inline bool runNextTask();
+
+    private:
+        juce::OwnedArray<Worker> mWorkers;
+        const int mNumSpins;
+        int mMinWork;
+
+    private:
+        Task mTask;
+        void* mContext;
+        juce::Atomic<int> mClaim;       //<! generation << 16 | number of tasks << 8 | next task
+        juce::Atomic<int> mNumDone;
+
+    private:
+        JUCE_DECLARE_NON_COPYABLE(WorkerPool);
+    };
+
+    // -------------------------------------------------------------------------
+
+    /*!
+        Implemented by the processors that may split their work across a WorkerPool,
+        for the hosts that run many of them side by side, such as the batch renderer,
+        to keep each one on its own thread rather than oversubscribe the cores.
+    */
+    class ParallelProcessor
+    {
+    public:
+        virtual ~ParallelProcessor() {}
+
+    public:
+        /*!
+            Called on the message thread: the next prepareToPlay starts no workers.
+        */
+        virtual void disableWorkers() = 0;
+    };
+
+    // -------------------------------------------------------------------------
+
+    /*!
+        JobQueue runs background jobs, such as preset file I/O, off the message and audio threads.
+        It is meant to be shared by all the plugin instances of a process, through a
+        juce::SharedResourcePointer: its workers are started once, and wait for jobs in between.
+        Jobs are posted without blocking, at most maxNumPendingJobs of them waiting at a time,
+        and each job's completed() is called back on the message thread once it has executed.
+    */
+    class JobQueue
+        : private juce::AsyncUpdater
+    {
+    public:
+        class Job
+        {
+        public:
+            /*!
+                inOwner identifies the object the job works for, for cancel().
+            */
+            explicit Job(const void* inOwner);
+            virtual ~Job();
+
+        public:
+            /*!
+                Called on a worker thread.
+            */
+            virtual void execute() = 0;
+
+            /*!
+                Called on the message thread once execute has returned, unless its owner cancelled it.
+            */
+            virtual void completed() = 0;
+
+        public:
+            const void* getOwner() const;
+
+        private:
+            const void* mOwner;
+
+        private:
+            JUCE_DECLARE_NON_COPYABLE(Job);
+        };
+
+        enum { numWorkers = 2, maxNumPendingJobs = 32 };
+
+    public:
+        JobQueue();
+        virtual ~JobQueue();
+
+    public:
+        /*!
+            Queues inJob, which the JobQueue owns from then on, and returns right away.
+            When maxNumPendingJobs are already waiting, inJob is deleted and false returned.
+        */
+        bool post(Job* inJob);
+
+        /*!
+            Drops the jobs of inOwner that have not started yet, waits for the running ones,
+            and drops their completion: to be called from the message thread before inOwner goes.
+        */
+        void cancel(const void* inOwner);
+
+    private: // juce::AsyncUpdater
+        virtual void handleAsyncUpdate();
+
+    private:
+        class Worker;
+
+    private:
+        Job* takeNextJob(int inWorker);
+        void finishJob(int inWorker, Job* inJob);
+
+    private:
+        juce::OwnedArray<Worker> mWorkers;
+        juce::CriticalSection mLock;
+        Job* mPendingJobs[maxNumPendingJobs];   //<! Circular, from mFirstPendingJob
+        int mFirstPendingJob;
+        int mNumPendingJobs;
+        Job* mRunningJobs[numWorkers];
+        juce::Array<Job*> mFinishedJobs;
+        juce::WaitableEvent mJobFinished;
+
+    private:
+        JUCE_DECLARE_NON_COPYABLE(JobQueue);
+    };
+
+    // -------------------------------------------------------------------------
+
+    /*!
+        ChannelGroups runs a chain cell (such as dsp::IIRCascade) over all the channel groups
+        of a block, each group of ChainType::numLanes channels having its own chain State.
+        Groups whose input is silent and whose chain is idle are skipped.
+        When a WorkerPool is given and the block is large enough, groups are split across it.
+    */
+    template<class ChainType, typename SampleType>
+    class ChannelGroups
+    {
+    public:
+        typedef typename ChainType::template State<SampleType> ChainState;
+
+    public:
+        static inline void process(const SampleType*const* inInputChannels, SampleType*const* inOutputChannels,
+                                   int inNumChannels, int inNumSamples,
+                                   const dsp::Gain::Port& inInputGain,
+                                   const dsp::IIR::Port*const* inSections,
+                                   const dsp::Gain::Port& inOutputGain,
+                                   ChainState* ioChains, WorkerPool* inWorkers)
+        {
+            const ChannelGroups job = { inInputChannels, inOutputChannels, inNumChannels, inNumSamples,
+                                        &inInputGain, inSections, &inOutputGain, ioChains };
+
+            const int numGroups = (inNumChannels + ChainType::numLanes - 1) / ChainType::numLanes;
+            if (inWorkers != 0 && inWorkers->isWorthSplitting(numGroups, inNumChannels * inNumSamples))
+            {
+                inWorkers->run(&ChannelGroups::processGroup, const_cast<ChannelGroups*>(&job), numGroups);
+                return;
+            }
+
+            for (int g = 0; g < numGroups; ++g)
+            {
+                job.processGroup(g);
+            }
+        }
+
+    private:
+        static void processGroup(void* inJob, int inGroup)
+        {
+            static_cast<const ChannelGroups*>(inJob)->processGroup(inGroup);
+        }
+
+        inline void processGroup(int inGroup) const
+        {
+            const int first         = inGroup * ChainType::numLanes;
+            const int numChannels   = std::min(int(ChainType::numLanes), mNumChannels - first);
+            ChainState& chain       = mChains[inGroup];
+
+            if (dsp::Silence::isSilent(mInputChannels + first, numChannels, mNumSamples) &&
+                ChainType::isIdle(chain))
+            {
+                ChainType::skip(mNumSamples, *mInputGain, mSections, *mOutputGain, chain);
+                dsp::Silence::clear(mOutputChannels + first, numChannels, mNumSamples);
+                return;
+            }
+
+            ChainType::process(mInputChannels + first, mOutputChannels + first, numChannels, mNumSamples,
+                               *mInputGain, mSections, *mOutputGain, chain);
+        }
+
+    public:
+        const SampleType*const* mInputChannels;
+        SampleType*const* mOutputChannels;
+        int mNumChannels;
+        int mNumSamples;
+        const dsp::Gain::Port* mInputGain;
+        const dsp::IIR::Port*const* mSections;
+        const dsp::Gain::Port* mOutputGain;
+        ChainState* mChains;
+    };
+}
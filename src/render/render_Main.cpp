@@ -0,0 +1,137 @@
+/*!
+ * \file       render_Main.cpp
+ * Copyright   Eiosis 2014
+ */
+
+/*
+    Headless batch renderer: streams WAV and AIFF files through a plugin processor, without a host.
+
+    render [-p preset] [-o directory] [-j jobs] [-b blocksize] [-t] [-s [-c]] files...
+
+        -p  applies a preset, as saved by the plugin
+        -o  output directory, "rendered" by default
+        -j  number of files (or segments, with -s) rendered at once, the number of cores by default
+        -b  processBlock size, 512 by default
+        -t  renders the processor tail after the end of each file
+        -s  splits each file in segments rendered in parallel, for long files
+        -c  checks split files against a sequential render, with -s only
+
+    Build as a console tool, linked with the sources of one plugin (such as src/rocky),
+    the framework, and the JUCE audio_formats and audio_processors modules:
+    it renders through the processor that plugin registers with REGISTER_PLUGIN_FILTER.
+*/
+
+#include "render/render_Renderer.h"
+
+#include <iostream>
+
+namespace render
+{
+    inline void printUsage()
+    {
+        std::cerr << "usage: render [-p preset] [-o directory] [-j jobs] [-b blocksize] [-t] [-s [-c]] files..."
+                  << std::endl;
+    }
+
+    inline bool parseArguments(const juce::StringArray& inArguments, Options& outOptions,
+                               juce::Array<juce::File>& outFiles)
+    {
+        const juce::File cwd = juce::File::getCurrentWorkingDirectory();
+
+        outOptions.mPreset          = juce::File::nonexistent;
+        outOptions.mOutputDirectory = cwd.getChildFile("rendered");
+        outOptions.mNumJobs         = juce::SystemStats::getNumCpus();
+        outOptions.mBlockSize       = 512;
+        outOptions.mRenderTail      = false;
+        outOptions.mSplitFiles      = false;
+        outOptions.mCheckSplit      = false;
+
+        for (int i = 0; i < inArguments.size(); ++i)
+        {
+            const juce::String& argument    = inArguments[i];
+            const bool hasValue             = i + 1 < inArguments.size();
+
+            if (argument == "-p" && hasValue)
+            {
+                outOptions.mPreset = cwd.getChildFile(inArguments[++i]);
+            }
+            else if (argument == "-o" && hasValue)
+            {
+                outOptions.mOutputDirectory = cwd.getChildFile(inArguments[++i]);
+            }
+            else if (argument == "-j" && hasValue)
+            {
+                outOptions.mNumJobs = inArguments[++i].getIntValue();
+            }
+            else if (argument == "-b" && hasValue)
+            {
+                outOptions.mBlockSize = inArguments[++i].getIntValue();
+            }
+            else if (argument == "-t")
+            {
+                outOptions.mRenderTail = true;
+            }
+            else if (argument == "-s")
+            {
+                outOptions.mSplitFiles = true;
+            }
+            else if (argument == "-c")
+            {
+                outOptions.mCheckSplit = true;
+            }
+            else if (argument.startsWithChar('-'))
+            {
+                return false;
+            }
+            else
+            {
+                outFiles.add(cwd.getChildFile(argument));
+            }
+        }
+
+        return outFiles.size() > 0 && outOptions.mNumJobs > 0 && outOptions.mBlockSize > 0;
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+int main(int argc, char* argv[])
+{
+    // Processors expect a message thread: this one
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::StringArray arguments;
+    for (int i = 1; i < argc; ++i)
+    {
+        arguments.add(juce::CharPointer_UTF8(argv[i]));
+    }
+
+    render::Options options;
+    juce::Array<juce::File> files;
+    if (!render::parseArguments(arguments, options, files))
+    {
+        render::printUsage();
+        return 2;
+    }
+    if (options.mCheckSplit && !options.mSplitFiles)
+    {
+        std::cerr << "-c checks split renders: it needs -s" << std::endl;
+        return 2;
+    }
+
+    render::Renderer renderer(options);
+    juce::StringArray failures;
+    juce::String error;
+    if (!renderer.render(files, failures, error))
+    {
+        std::cerr << error.toRawUTF8() << std::endl;
+        return 1;
+    }
+
+    for (int i = 0; i < failures.size(); ++i)
+    {
+        std::cerr << failures[i].toRawUTF8() << std::endl;
+    }
+    std::cout << (files.size() - failures.size()) << " of " << files.size() << " files rendered." << std::endl;
+    return failures.size() == 0 ? 0 : 1;
+}
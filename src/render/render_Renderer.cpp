@@ -0,0 +1,670 @@
+/*!
+ * \file       render_Renderer.cpp
+ * Copyright   Eiosis 2014
+ */
+
+#include "render/render_Renderer.h"
+#include "framework/framework_Cells.h"
+#include "framework/framework_Workers.h"
+
+// Defined by the REGISTER_PLUGIN_FILTER of the plugin the renderer is linked with
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter();
+
+namespace render
+{
+    class Renderer::Job : public juce::Thread
+    {
+    public:
+        Job(const Renderer& inRenderer, juce::AudioProcessor& inProcessor, const juce::Array<juce::File>& inFiles,
+            juce::Atomic<int>& ioNextFile, juce::StringArray& outFailures)
+            : juce::Thread("Renderer Job")
+            , mRenderer(inRenderer)
+            , mProcessor(inProcessor)
+            , mFiles(inFiles)
+            , mNextFile(ioNextFile)
+            , mFailures(outFailures)
+        {}
+
+    public: // juce::Thread
+        virtual void run()
+        {
+            for (int i = ++mNextFile - 1; i < mFiles.size() && !threadShouldExit(); i = ++mNextFile - 1)
+            {
+                juce::String error;
+                if (!mRenderer.renderFile(mProcessor, mFiles.getReference(i), error))
+                {
+                    // Each file has its own slot, so that jobs never write the same String
+                    mFailures.set(i, mFiles.getReference(i).getFullPathName() + ": " + error);
+                }
+            }
+        }
+
+    private:
+        const Renderer& mRenderer;
+        juce::AudioProcessor& mProcessor;
+        const juce::Array<juce::File>& mFiles;
+        juce::Atomic<int>& mNextFile;
+        juce::StringArray& mFailures;
+
+    private:
+        JUCE_DECLARE_NON_COPYABLE(Job);
+    };
+
+    // -------------------------------------------------------------------------
+
+    /*!
+        Sinks are handed each processed chunk with the position it was pushed at,
+        which is latency samples ahead of the output position.
+    */
+    class Renderer::FileWriter
+    {
+    public:
+        FileWriter(juce::AudioFormatWriter& ioWriter, int inLatency)
+            : mWriter(ioWriter)
+            , mLatency(inLatency)
+        {}
+
+    public:
+        bool operator()(const juce::AudioBuffer<float>& inChunk, juce::int64 inPosition, int inNumSamples)
+        {
+            const int first = int(juce::jlimit(juce::int64(0), juce::int64(inNumSamples), mLatency - inPosition));
+            return mWriter.writeFromAudioSampleBuffer(inChunk, first, inNumSamples - first);
+        }
+
+    private:
+        juce::AudioFormatWriter& mWriter;
+        const int mLatency;
+
+    private:
+        JUCE_DECLARE_NON_COPYABLE(FileWriter);
+    };
+
+    /*!
+        Keeps the output samples of [inBegin, inEnd[ in ioSegment, dropping the pre-roll.
+    */
+    class Renderer::SegmentWriter
+    {
+    public:
+        SegmentWriter(juce::AudioBuffer<float>& ioSegment, juce::int64 inBegin, juce::int64 inEnd, int inLatency)
+            : mSegment(ioSegment)
+            , mBegin(inBegin + inLatency)
+            , mEnd(inEnd + inLatency)
+        {}
+
+    public:
+        bool operator()(const juce::AudioBuffer<float>& inChunk, juce::int64 inPosition, int inNumSamples)
+        {
+            const juce::int64 begin = std::max(inPosition, mBegin);
+            const juce::int64 end   = std::min(inPosition + inNumSamples, mEnd);
+            for (int c = 0; c < inChunk.getNumChannels() && begin < end; ++c)
+            {
+                mSegment.copyFrom(c, int(begin - mBegin), inChunk, c, int(begin - inPosition), int(end - begin));
+            }
+            return true;
+        }
+
+    private:
+        juce::AudioBuffer<float>& mSegment;
+        const juce::int64 mBegin;
+        const juce::int64 mEnd;
+
+    private:
+        JUCE_DECLARE_NON_COPYABLE(SegmentWriter);
+    };
+
+    /*!
+        Compares the sequential render of a round of segments with the segments.
+    */
+    class Renderer::SegmentChecker
+    {
+    public:
+        SegmentChecker(const juce::OwnedArray<juce::AudioBuffer<float> >& inSegments, juce::int64 inBegin,
+                       juce::int64 inEnd, juce::int64 inSegmentSize, int inLatency)
+            : mSegments(inSegments)
+            , mBegin(inBegin + inLatency)
+            , mEnd(inEnd + inLatency)
+            , mSegmentSize(inSegmentSize)
+            , mMaxError(0.f)
+        {}
+
+    public:
+        bool operator()(const juce::AudioBuffer<float>& inChunk, juce::int64 inPosition, int inNumSamples)
+        {
+            const juce::int64 begin = std::max(inPosition, mBegin);
+            const juce::int64 end   = std::min(inPosition + inNumSamples, mEnd);
+            for (juce::int64 i = begin; i < end; ++i)
+            {
+                const juce::AudioBuffer<float>& segment = *mSegments[int((i - mBegin) / mSegmentSize)];
+                const int index                         = int((i - mBegin) % mSegmentSize);
+                for (int c = 0; c < inChunk.getNumChannels(); ++c)
+                {
+                    const float error = std::abs(inChunk.getSample(c, int(i - inPosition)) - segment.getSample(c, index));
+                    mMaxError = std::max(mMaxError, error);
+                }
+            }
+            return true;
+        }
+
+    public:
+        float getMaxError() const
+        {
+            return mMaxError;
+        }
+
+    private:
+        const juce::OwnedArray<juce::AudioBuffer<float> >& mSegments;
+        const juce::int64 mBegin;
+        const juce::int64 mEnd;
+        const juce::int64 mSegmentSize;
+        float mMaxError;
+
+    private:
+        JUCE_DECLARE_NON_COPYABLE(SegmentChecker);
+    };
+
+    // -------------------------------------------------------------------------
+
+    template<typename SampleType>
+    void Renderer::processBlocks(juce::AudioProcessor& ioProcessor, juce::AudioBuffer<SampleType>& ioChunk,
+                                 int inNumSamples, juce::MidiBuffer& ioMidi) const
+    {
+        for (int offset = 0; offset < inNumSamples; offset += mOptions.mBlockSize)
+        {
+            juce::AudioBuffer<SampleType> block(ioChunk.getArrayOfWritePointers(), ioChunk.getNumChannels(), offset,
+                                                std::min(mOptions.mBlockSize, inNumSamples - offset));
+            ioProcessor.processBlock(block, ioMidi);
+        }
+    }
+
+    /*!
+        Pushes the samples [inBegin, inEnd[ of the file through ioProcessor, silence past its end,
+        one memory mapped chunk at a time, and hands each processed chunk out to ioSink.
+    */
+    template<class SinkType>
+    bool Renderer::process(juce::AudioProcessor& ioProcessor, juce::MemoryMappedAudioFormatReader& inReader,
+                           juce::int64 inBegin, juce::int64 inEnd, SinkType& ioSink) const
+    {
+        const int numChannels   = int(inReader.numChannels);
+        const bool isDouble     = ioProcessor.isUsingDoublePrecision();
+
+        juce::AudioBuffer<float> chunk(numChannels, chunkSize);
+        juce::AudioBuffer<double> doubleChunk(isDouble ? numChannels : 0, isDouble ? int(chunkSize) : 0);
+        juce::MidiBuffer midi;
+
+        for (juce::int64 position = inBegin; position < inEnd; position += chunkSize)
+        {
+            const int numChunkSamples   = int(std::min(juce::int64(chunkSize), inEnd - position));
+            const int numFileSamples    = int(juce::jlimit(juce::int64(0), juce::int64(numChunkSamples),
+                                                           inReader.lengthInSamples - position));
+
+            if (numFileSamples > 0)
+            {
+                if (!inReader.mapSectionOfFile(juce::Range<juce::int64>(position, position + numFileSamples)))
+                {
+                    return false;
+                }
+                inReader.read(&chunk, 0, numFileSamples, position, true, true);
+            }
+            chunk.clear(numFileSamples, numChunkSamples - numFileSamples);
+
+            if (isDouble)
+            {
+                doubleChunk.makeCopyOf(chunk);
+                processBlocks(ioProcessor, doubleChunk, numChunkSamples, midi);
+                chunk.makeCopyOf(doubleChunk);
+            }
+            else
+            {
+                processBlocks(ioProcessor, chunk, numChunkSamples, midi);
+            }
+
+            if (!ioSink(chunk, position, numChunkSamples))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // -------------------------------------------------------------------------
+
+    /*!
+        Renders the output samples [inBegin, inEnd[ of a file to ioSegment,
+        starting from a fresh state inPreRoll samples earlier.
+    */
+    class Renderer::SegmentJob : public juce::Thread
+    {
+    public:
+        SegmentJob(const Renderer& inRenderer, juce::AudioProcessor& inProcessor, const juce::File& inFile,
+                   juce::int64 inBegin, juce::int64 inEnd, juce::int64 inPreRoll, juce::AudioBuffer<float>& ioSegment)
+            : juce::Thread("Renderer Segment Job")
+            , mRenderer(inRenderer)
+            , mProcessor(inProcessor)
+            , mFile(inFile)
+            , mBegin(inBegin)
+            , mEnd(inEnd)
+            , mPreRoll(inPreRoll)
+            , mSegment(ioSegment)
+            , mStatus(false)
+        {}
+
+    public: // juce::Thread
+        virtual void run()
+        {
+            juce::ScopedPointer<juce::MemoryMappedAudioFormatReader> reader(mRenderer.createReader(mFile, mError));
+            if (reader == 0)
+            {
+                return;
+            }
+
+            mRenderer.prepare(mProcessor, *reader);
+            const int latency = mProcessor.getLatencySamples();
+
+            SegmentWriter writer(mSegment, mBegin, mEnd, latency);
+            mStatus = mRenderer.process(mProcessor, *reader, std::max(mBegin - mPreRoll, juce::int64(0)),
+                                        mEnd + latency, writer);
+            mProcessor.releaseResources();
+
+            if (!mStatus)
+            {
+                mError = "Can't render file.";
+            }
+        }
+
+    public:
+        bool getStatus(juce::String& outError) const
+        {
+            outError = mError;
+            return mStatus;
+        }
+
+    private:
+        const Renderer& mRenderer;
+        juce::AudioProcessor& mProcessor;
+        const juce::File mFile;
+        const juce::int64 mBegin;
+        const juce::int64 mEnd;
+        const juce::int64 mPreRoll;
+        juce::AudioBuffer<float>& mSegment;
+        bool mStatus;
+        juce::String mError;
+
+    private:
+        JUCE_DECLARE_NON_COPYABLE(SegmentJob);
+    };
+
+    // -------------------------------------------------------------------------
+
+    Renderer::Renderer(const Options& inOptions)
+        : mOptions(inOptions)
+    {
+        mFormats.registerFormat(new juce::WavAudioFormat(), true);
+        mFormats.registerFormat(new juce::AiffAudioFormat(), false);
+    }
+
+    Renderer::~Renderer()
+    {
+
+    }
+
+    // -------------------------------------------------------------------------
+
+    bool Renderer::render(const juce::Array<juce::File>& inFiles, juce::StringArray& outFailures,
+                          juce::String& outError)
+    {
+        jassert(juce::MessageManager::getInstance()->isThisTheMessageThread());
+
+        mPreset.reset();
+        if (mOptions.mPreset != juce::File::nonexistent && !mOptions.mPreset.loadFileAsData(mPreset))
+        {
+            outError = "Can't load Preset.";
+            return false;
+        }
+        if (!checkOutputFiles(inFiles, outError))
+        {
+            return false;
+        }
+        if (mOptions.mOutputDirectory.createDirectory().failed())
+        {
+            outError = "Can't create output directory.";
+            return false;
+        }
+
+        // Split files need a processor per job whatever the number of files, and one more to check them
+        const int numJobs = mOptions.mSplitFiles ? std::max(mOptions.mNumJobs, 1) :
+                                                   juce::jlimit(1, std::max(inFiles.size(), 1), mOptions.mNumJobs);
+        const int numProcessors = numJobs + (mOptions.mSplitFiles && mOptions.mCheckSplit ? 1 : 0);
+
+        mProcessors.clear();
+        for (int i = 0; i < numProcessors; ++i)
+        {
+            juce::AudioProcessor* processor = createProcessor(outError);
+            if (processor == 0)
+            {
+                return false;
+            }
+            mProcessors.add(processor);
+        }
+
+        outFailures.clear();
+        for (int i = 0; i < inFiles.size(); ++i)
+        {
+            outFailures.add(juce::String::empty);
+        }
+
+        if (mOptions.mSplitFiles)
+        {
+            for (int i = 0; i < inFiles.size(); ++i)
+            {
+                juce::String error;
+                if (!renderSplitFile(inFiles.getReference(i), error))
+                {
+                    outFailures.set(i, inFiles.getReference(i).getFullPathName() + ": " + error);
+                }
+            }
+        }
+        else
+        {
+            juce::OwnedArray<Job> jobs;
+            juce::Atomic<int> nextFile;
+            nextFile.set(0);
+
+            for (int i = 0; i < numJobs; ++i)
+            {
+                jobs.add(new Job(*this, *mProcessors[i], inFiles, nextFile, outFailures));
+            }
+            for (int i = 0; i < jobs.size(); ++i)
+            {
+                jobs[i]->startThread();
+            }
+            for (int i = 0; i < jobs.size(); ++i)
+            {
+                jobs[i]->waitForThreadToExit(-1);
+            }
+        }
+
+        mProcessors.clear();
+        outFailures.removeEmptyStrings();
+        return true;
+    }
+
+    double Renderer::maxSplitErrordB()
+    {
+        return -100.;
+    }
+
+    // -------------------------------------------------------------------------
+
+    juce::File Renderer::getOutputFile(const juce::File& inFile) const
+    {
+        return mOptions.mOutputDirectory.getChildFile(inFile.getFileName());
+    }
+
+    /*!
+        Outputs replace the files of the same name: none may be an input, nor the output of another input,
+        which parallel jobs would write together.
+    */
+    bool Renderer::checkOutputFiles(const juce::Array<juce::File>& inFiles, juce::String& outError) const
+    {
+        const bool caseSensitive = juce::File::areFileNamesCaseSensitive();
+        juce::HashMap<juce::String, int> inputs;
+        for (int i = 0; i < inFiles.size(); ++i)
+        {
+            const juce::String path = inFiles.getReference(i).getFullPathName();
+            inputs.set(caseSensitive ? path : path.toLowerCase(), i);
+        }
+
+        juce::HashMap<juce::String, int> outputs;
+        for (int i = 0; i < inFiles.size(); ++i)
+        {
+            const juce::String path = getOutputFile(inFiles.getReference(i)).getFullPathName();
+            const juce::String key  = caseSensitive ? path : path.toLowerCase();
+            if (inputs.contains(key))
+            {
+                outError = "Output would overwrite input file " + path + ".";
+                return false;
+            }
+            if (outputs.contains(key))
+            {
+                outError = inFiles.getReference(outputs[key]).getFullPathName() + " and " +
+                           inFiles.getReference(i).getFullPathName() + " would both render to " + path + ".";
+                return false;
+            }
+            outputs.set(key, i);
+        }
+        return true;
+    }
+
+    // -------------------------------------------------------------------------
+
+    /*!
+        Processors only map their parameters once they have a samplerate,
+        so the preset is applied to a processor prepared at a default configuration.
+        The next prepareToPlay maps the preset values again at the file samplerate.
+    */
+    /*!
+        Jobs are the parallelism of the renderer: the processors of the framework start no workers
+        of their own, which would run on the cores of the other jobs.
+    */
+    juce::AudioProcessor* Renderer::createProcessor(juce::String& outError) const
+    {
+        juce::ScopedPointer<juce::AudioProcessor> processor(createPluginFilter());
+        if (plugin::ParallelProcessor* parallel = dynamic_cast<plugin::ParallelProcessor*>(processor.get()))
+        {
+            parallel->disableWorkers();
+        }
+        if (mPreset.getSize() == 0)
+        {
+            return processor.release();
+        }
+
+        processor->setPlayConfigDetails(2, 2, 44100., mOptions.mBlockSize);
+        processor->prepareToPlay(44100., mOptions.mBlockSize);
+        processor->setStateInformation(mPreset.getData(), int(mPreset.getSize()));
+        processor->releaseResources();
+
+        juce::MemoryBlock state;
+        processor->getStateInformation(state);
+        if (state != mPreset)
+        {
+            outError = "Preset does not match " + processor->getName() + ".";
+            return 0;
+        }
+        return processor.release();
+    }
+
+    juce::MemoryMappedAudioFormatReader* Renderer::createReader(const juce::File& inFile, juce::String& outError) const
+    {
+        juce::AudioFormat* format = mFormats.findFormatForFileExtension(inFile.getFileExtension());
+        if (format == 0)
+        {
+            outError = "Unsupported file format.";
+            return 0;
+        }
+
+        juce::ScopedPointer<juce::MemoryMappedAudioFormatReader> reader(format->createMemoryMappedReader(inFile));
+        if (reader == 0 || reader->numChannels == 0)
+        {
+            outError = "Can't open input file.";
+            return 0;
+        }
+        return reader.release();
+    }
+
+    juce::AudioFormatWriter* Renderer::createWriter(const juce::File& inFile, const juce::AudioFormatReader& inReader,
+                                                    juce::String& outError) const
+    {
+        juce::AudioFormat* format   = mFormats.findFormatForFileExtension(inFile.getFileExtension());
+        const juce::File outFile    = getOutputFile(inFile);
+        outFile.deleteFile();
+
+        juce::ScopedPointer<juce::FileOutputStream> stream(outFile.createOutputStream(outputBufferSize));
+        juce::ScopedPointer<juce::AudioFormatWriter> writer(stream == 0 || format == 0 ? 0 :
+            format->createWriterFor(stream, inReader.sampleRate, inReader.numChannels,
+                                    int(inReader.bitsPerSample), inReader.metadataValues, 0));
+        if (writer == 0)
+        {
+            outError = "Can't create output file.";
+            return 0;
+        }
+        stream.release();
+        return writer.release();
+    }
+
+    /*!
+        Processors are prepared non-realtime, as a host bouncing offline would, for those that oversample then.
+        Offline, processors run in double precision when they can: the float32 rounding noise of a long IIR chain
+        is different for each starting point, what would set a floor to how close split renders can get.
+    */
+    void Renderer::prepare(juce::AudioProcessor& ioProcessor, const juce::AudioFormatReader& inReader) const
+    {
+        const int numChannels = int(inReader.numChannels);
+        ioProcessor.setNonRealtime(true);
+        if (ioProcessor.supportsDoublePrecisionProcessing())
+        {
+            ioProcessor.setProcessingPrecision(juce::AudioProcessor::doublePrecision);
+        }
+        ioProcessor.setPlayConfigDetails(numChannels, numChannels, inReader.sampleRate, mOptions.mBlockSize);
+        ioProcessor.prepareToPlay(inReader.sampleRate, mOptions.mBlockSize);
+    }
+
+    // -------------------------------------------------------------------------
+
+    bool Renderer::renderFile(juce::AudioProcessor& ioProcessor, const juce::File& inFile,
+                              juce::String& outError) const
+    {
+        juce::ScopedPointer<juce::MemoryMappedAudioFormatReader> reader(createReader(inFile, outError));
+        if (reader == 0)
+        {
+            return false;
+        }
+        juce::ScopedPointer<juce::AudioFormatWriter> writer(createWriter(inFile, *reader, outError));
+        if (writer == 0)
+        {
+            return false;
+        }
+
+        prepare(ioProcessor, *reader);
+
+        // The first latency samples out are dropped, and as many are pushed in past the end of the file
+        const int latency               = ioProcessor.getLatencySamples();
+        const juce::int64 numSamples    = reader->lengthInSamples + (mOptions.mRenderTail ?
+                                          juce::int64(ioProcessor.getTailLengthSeconds() * reader->sampleRate) : 0);
+
+        FileWriter sink(*writer, latency);
+        const bool status = process(ioProcessor, *reader, 0, numSamples + latency, sink);
+        ioProcessor.releaseResources();
+
+        if (!status)
+        {
+            outError = "Can't render file.";
+        }
+        return status;
+    }
+
+    bool Renderer::renderSplitFile(const juce::File& inFile, juce::String& outError)
+    {
+        juce::ScopedPointer<juce::MemoryMappedAudioFormatReader> reader(createReader(inFile, outError));
+        if (reader == 0)
+        {
+            return false;
+        }
+
+        juce::AudioProcessor& processor = *mProcessors.getFirst();
+        prepare(processor, *reader);
+
+        const double samplerate         = reader->sampleRate;
+        const double tailLength         = processor.getTailLengthSeconds();
+        const double settleTime         = dsp::Gain::rampTime() * std::log(1. / dsp::Silence::threshold());
+        const int latency               = processor.getLatencySamples();
+        const juce::int64 numSamples    = reader->lengthInSamples +
+                                          (mOptions.mRenderTail ? juce::int64(tailLength * samplerate) : 0);
+        const juce::int64 preRoll       = juce::int64(std::ceil((tailLength + settleTime) * samplerate)) + latency;
+        const juce::int64 segmentSize   = std::max(juce::int64(minSegmentSeconds * samplerate),
+                                                   juce::int64(maxSegmentPreRolls) * preRoll);
+        const int numJobs               = mProcessors.size() - (mOptions.mCheckSplit ? 1 : 0);
+        processor.releaseResources();
+
+        // Shorter files are not worth the pre-rolls
+        if (numJobs < 2 || numSamples < 2 * segmentSize)
+        {
+            reader = 0;
+            return renderFile(processor, inFile, outError);
+        }
+
+        juce::ScopedPointer<juce::AudioFormatWriter> writer(createWriter(inFile, *reader, outError));
+        if (writer == 0)
+        {
+            return false;
+        }
+
+        juce::OwnedArray<juce::AudioBuffer<float> > segments;
+        for (int i = 0; i < numJobs; ++i)
+        {
+            segments.add(new juce::AudioBuffer<float>(int(reader->numChannels), int(segmentSize)));
+        }
+
+        // The check renders the whole file sequentially, round after round
+        juce::AudioProcessor& checkProcessor = *mProcessors.getLast();
+        if (mOptions.mCheckSplit)
+        {
+            prepare(checkProcessor, *reader);
+        }
+        juce::int64 numCheckedSamples   = 0;
+        float maxError                  = 0.f;
+
+        bool status = true;
+        for (juce::int64 begin = 0; begin < numSamples && status; begin += numJobs * segmentSize)
+        {
+            const juce::int64 end = std::min(begin + numJobs * segmentSize, numSamples);
+
+            juce::OwnedArray<SegmentJob> jobs;
+            for (int i = 0; begin + i * segmentSize < end; ++i)
+            {
+                const juce::int64 segmentBegin = begin + i * segmentSize;
+                jobs.add(new SegmentJob(*this, *mProcessors[i], inFile, segmentBegin,
+                                        std::min(segmentBegin + segmentSize, end), preRoll, *segments[i]));
+            }
+            for (int i = 0; i < jobs.size(); ++i)
+            {
+                jobs[i]->startThread();
+            }
+            for (int i = 0; i < jobs.size(); ++i)
+            {
+                jobs[i]->waitForThreadToExit(-1);
+                status = status && jobs[i]->getStatus(outError);
+            }
+
+            if (status && mOptions.mCheckSplit)
+            {
+                SegmentChecker checker(segments, begin, end, segmentSize, latency);
+                status              = process(checkProcessor, *reader, numCheckedSamples, end + latency, checker);
+                numCheckedSamples   = end + latency;
+                maxError            = std::max(maxError, checker.getMaxError());
+            }
+
+            for (int i = 0; i < jobs.size() && status; ++i)
+            {
+                const int numSegmentSamples = int(std::min(segmentSize, end - begin - i * segmentSize));
+                status = writer->writeFromAudioSampleBuffer(*segments[i], 0, numSegmentSamples);
+            }
+        }
+
+        if (mOptions.mCheckSplit)
+        {
+            checkProcessor.releaseResources();
+        }
+
+        if (status && mOptions.mCheckSplit && maxError > juce::Decibels::decibelsToGain(maxSplitErrordB()))
+        {
+            outError    = "Split render differs from the sequential render by " +
+                          juce::String(juce::Decibels::gainToDecibels(maxError), 1) + " dB.";
+            status      = false;
+        }
+        else if (!status && outError.isEmpty())
+        {
+            outError = "Can't render file.";
+        }
+        return status;
+    }
+}
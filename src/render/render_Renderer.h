@@ -0,0 +1,101 @@
+/*!
+ * \file       render_Renderer.h
+ * Copyright   Eiosis 2014
+ */
+
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace render
+{
+    struct Options
+    {
+        juce::File mPreset;             //<! Processor state as the preset savers write it, none for the defaults
+        juce::File mOutputDirectory;    //<! Rendered files are written there, under their input name
+        int mNumJobs;                   //<! Files, or segments of a file, rendered at once, each by its own processor
+        int mBlockSize;                 //<! Samples per processBlock call
+        bool mRenderTail;               //<! Appends the processor tail to each file
+        bool mSplitFiles;               //<! Renders each file by segments across all jobs, rather than files in parallel
+        bool mCheckSplit;               //<! Renders split files sequentially as well, and fails those that differ
+    };
+
+    // -------------------------------------------------------------------------
+
+    /*!
+        The Renderer streams audio files through the processor createPluginFilter returns,
+        the way a host would, without one.
+        Inputs are memory mapped one chunk at a time, processed by blocks (in double precision when the processor
+        supports it), and written through a buffered stream, in the format and resolution of the input,
+        with the processor latency compensated.
+        Each job owns a processor, and renders the next pending file until all of them are rendered.
+        Processors are created, and get their preset, on the calling (message) thread.
+
+        When splitting files, each job renders one segment of the file at a time from a fresh state,
+        pre-rolled on the audio preceding its segment for as long as the processor state takes to forget it:
+        its tail length, plus the time parameter ramps take to settle.
+        The processor being linear with decaying states, segments then match the sequential render
+        within the silence threshold, what the check option verifies.
+    */
+    class Renderer
+    {
+    public:
+        enum { chunkSize = 65536, outputBufferSize = 1 << 20, minSegmentSeconds = 60, maxSegmentPreRolls = 8 };
+
+    public:
+        explicit Renderer(const Options& inOptions);
+        ~Renderer();
+
+    public:
+        /*!
+            Renders all inFiles, and returns false with outError if the options can't be used.
+            Files that fail are reported to outFailures.
+        */
+        bool render(const juce::Array<juce::File>& inFiles, juce::StringArray& outFailures, juce::String& outError);
+
+    public:
+        /*!
+            Largest difference to the sequential render a split render may show, in dB full scale.
+        */
+        static double maxSplitErrordB();
+
+    private:
+        class Job;
+        class SegmentJob;
+        class FileWriter;
+        class SegmentWriter;
+        class SegmentChecker;
+
+    private:
+        juce::File getOutputFile(const juce::File& inFile) const;
+        bool checkOutputFiles(const juce::Array<juce::File>& inFiles, juce::String& outError) const;
+
+    private:
+        juce::AudioProcessor* createProcessor(juce::String& outError) const;
+        juce::MemoryMappedAudioFormatReader* createReader(const juce::File& inFile, juce::String& outError) const;
+        juce::AudioFormatWriter* createWriter(const juce::File& inFile, const juce::AudioFormatReader& inReader,
+                                              juce::String& outError) const;
+        void prepare(juce::AudioProcessor& ioProcessor, const juce::AudioFormatReader& inReader) const;
+
+    private:
+        bool renderFile(juce::AudioProcessor& ioProcessor, const juce::File& inFile, juce::String& outError) const;
+        bool renderSplitFile(const juce::File& inFile, juce::String& outError);
+
+    private:
+        template<class SinkType>
+        bool process(juce::AudioProcessor& ioProcessor, juce::MemoryMappedAudioFormatReader& inReader,
+                     juce::int64 inBegin, juce::int64 inEnd, SinkType& ioSink) const;
+        template<typename SampleType>
+        void processBlocks(juce::AudioProcessor& ioProcessor, juce::AudioBuffer<SampleType>& ioChunk,
+                           int inNumSamples, juce::MidiBuffer& ioMidi) const;
+
+    private:
+        const Options mOptions;
+        juce::AudioFormatManager mFormats;
+        juce::MemoryBlock mPreset;
+        juce::OwnedArray<juce::AudioProcessor> mProcessors;
+
+    private:
+        JUCE_DECLARE_NON_COPYABLE(Renderer);
+    };
+}
@@ -10,6 +10,8 @@ namespace rocky
 {
     static const int gMainLabelHeight   = 28;
     static const int gAuxLabelHeight    = 24;
+    static const int gPresetListHeight  = 120;
+    static const float gPresetParameterRange = .05f;    //<! Normalized distance to the current value
 
     class RockyEditor::Gain : public juce::Component
     {
@@ -228,20 +230,50 @@ namespace rocky
         , mOutputGain(new Gain(this, "Output", rocky::paramOutGain))
         , mSavePresetButton(new juce::TextButton("Save Preset", "Save Preset"))
         , mLoadPresetButton(new juce::TextButton("Load Preset", "Load Preset"))
+        , mRescanPresetsButton(new juce::TextButton("Rescan", "Rescan Presets"))
+        , mPresetFilter(new juce::TextEditor("Preset Filter"))
+        , mPresetParameter(new juce::ComboBox("Preset Parameter"))
+        , mPresetList(new juce::ListBox("Presets", this))
         , mLogo(juce::ImageFileFormat::loadFrom(BinaryData::resources_EiosisLogo_png,
                                                 BinaryData::resources_EiosisLogo_pngSize))
     {
         addAndMakeVisible(mSavePresetButton);
         addAndMakeVisible(mLoadPresetButton);
+        addAndMakeVisible(mRescanPresetsButton);
+        addAndMakeVisible(mPresetFilter);
+        addAndMakeVisible(mPresetParameter);
+        addAndMakeVisible(mPresetList);
 
         mSavePresetButton->addListener(this);
         mLoadPresetButton->addListener(this);
+        mRescanPresetsButton->addListener(this);
 
-        setSize(750, 410);
+        mPresetFilter->setTextToShowWhenEmpty("Search", juce::Colours::grey);
+        mPresetFilter->addListener(this);
+        mPresetParameter->addItem("Any Setting", 1);
+        for (int i = 0; i < rocky::numParameters; ++i)
+        {
+            mPresetParameter->addItem("Near " + inProcessor->getParameterName(i), i + 2);
+        }
+        mPresetParameter->setSelectedId(1, juce::dontSendNotification);
+        mPresetParameter->addListener(this);
+        mPresetList->setColour(juce::ListBox::backgroundColourId, juce::Colour(0xff2a2a2a));
+
+        // The cache is up to date as of the last session: scan once per session,
+        // then after each save and on request
+        inProcessor->getPresetIndex().addChangeListener(this);
+        if (inProcessor->getPresetIndex().isStale())
+        {
+            inProcessor->scanPresets();
+        }
+        updatePresetList();
+
+        setSize(750, 410 + gPresetListHeight);
     }
 
     RockyEditor::~RockyEditor()
     {
+        getProcessor()->getPresetIndex().removeChangeListener(this);
         deleteAllChildren();
     }
 
@@ -258,15 +290,30 @@ namespace rocky
         int y = offset;
 
         mSavePresetButton->setBounds(x, y, buttonW, buttonH);
+
+        // The preset filter, parameter and rescan button fill the space between the buttons
+        const int searchX   = x + buttonW + offset;
+        const int searchW   = (getWidth() >> 1) - buttonW - 2 * offset;
+        const int filterW   = searchW / 3;
+        const int rescanW   = 60;
+
+        mPresetFilter->setBounds(searchX, y, filterW, buttonH);
+        mPresetParameter->setBounds(searchX + filterW + offset, y,
+                                    searchW - filterW - rescanW - 2 * offset, buttonH);
+        mRescanPresetsButton->setBounds(searchX + searchW - rescanW, y, rescanW, buttonH);
         x += getWidth() >> 1;
         mLoadPresetButton->setBounds(x, y, buttonW, buttonH);
 
-        const int w = (getWidth() - 9 * offset) / 8;
-        const int h = getHeight() - y;
+        // The preset list runs along the bottom
+        mPresetList->setBounds(offset, getHeight() - gPresetListHeight - offset,
+                               getWidth() - 2 * offset, gPresetListHeight);
 
         y += buttonH + offset;
         x = offset;
 
+        const int w = (getWidth() - 9 * offset) / 8;
+        const int h = getHeight() - gPresetListHeight - 2 * offset - y;
+
         mInputGain->setBounds(x, y, w, h);
         x += w + offset;
         mHP->setBounds(x, y, w, h);
@@ -296,27 +343,84 @@ namespace rocky
 
     void RockyEditor::buttonClicked(juce::Button* inButton)
     {
-        juce::FileChooser fc("Save Preset",
-                             juce::File::getSpecialLocation(juce::File::userDocumentsDirectory),
-                             "*.*", true);
+        if (inButton == mRescanPresetsButton)
+        {
+            getProcessor()->scanPresets();
+            return;
+        }
+
+        RockyProcessor::getPresetsDirectory().createDirectory();
+        juce::FileChooser fc("Save Preset", RockyProcessor::getPresetsDirectory(), "*.*", true);
         if (inButton == mSavePresetButton)
         {
             if (fc.browseForFileToSave(true))
             {
-				reinterpret_cast<RockyProcessor*>(getAudioProcessor())->savePresetTo(fc.getResult());
+                getProcessor()->savePresetTo(fc.getResult());
             }
         }
         else if (inButton == mLoadPresetButton)
         {
             if (fc.browseForFileToOpen())
             {
-                reinterpret_cast<RockyProcessor*>(getAudioProcessor())->loadPresetFrom(fc.getResult());
+                getProcessor()->loadPresetFrom(fc.getResult());
             }
         }
     }
 
+    void RockyEditor::comboBoxChanged(juce::ComboBox*)
+    {
+        updatePresetList();
+    }
+
+    void RockyEditor::textEditorTextChanged(juce::TextEditor&)
+    {
+        updatePresetList();
+    }
+
+    // -------------------------------------------------------------------------
+
+    int RockyEditor::getNumRows()
+    {
+        return mPresetResults.size();
+    }
+
+    void RockyEditor::paintListBoxItem(int inRow, juce::Graphics& inGraphics,
+                                       int inWidth, int inHeight, bool inIsSelected)
+    {
+        if (inRow < 0 || inRow >= mPresetResults.size())
+        {
+            return;
+        }
+        if (inIsSelected)
+        {
+            inGraphics.fillAll(juce::Colour(0xff4a4a4a));
+        }
+        inGraphics.setColour(juce::Colours::white);
+        inGraphics.setFont(juce::Font(12.f));
+        inGraphics.drawText(getProcessor()->getPresetIndex().getName(mPresetResults[inRow]),
+                            4, 0, inWidth - 8, inHeight, juce::Justification::centredLeft, true);
+    }
+
+    void RockyEditor::listBoxItemClicked(int inRow, const juce::MouseEvent&)
+    {
+        if (inRow >= 0 && inRow < mPresetResults.size())
+        {
+            getProcessor()->loadPresetFrom(getProcessor()->getPresetIndex().getFile(mPresetResults[inRow]));
+        }
+    }
+
+    void RockyEditor::changeListenerCallback(juce::ChangeBroadcaster*)
+    {
+        updatePresetList();
+    }
+
     // -------------------------------------------------------------------------
 
+    RockyProcessor* RockyEditor::getProcessor() const
+    {
+        return static_cast<RockyProcessor*>(getAudioProcessor());
+    }
+
     void RockyEditor::configureLabel(juce::Label* inLabel, bool inIsMain) const
     {
         if (inIsMain)
@@ -329,4 +433,42 @@ namespace rocky
         }
         inLabel->setJustificationType(juce::Justification::centred);
     }
+
+    void RockyEditor::updatePresetList()
+    {
+        const plugin::PresetIndex& index    = getProcessor()->getPresetIndex();
+        const int parameter                 = mPresetParameter->getSelectedId() - 2;
+
+        mPresetResults = index.findByName(mPresetFilter->getText());
+        if (parameter >= 0)
+        {
+            // Both results are in index order: keep the entries found by both
+            const float value               = getProcessor()->getParameter(parameter);
+            const juce::Array<int> nearby   = index.findByParameter(parameter,
+                                                                    value - gPresetParameterRange,
+                                                                    value + gPresetParameterRange);
+            juce::Array<int> both;
+            for (int i = 0, j = 0; i < mPresetResults.size() && j < nearby.size();)
+            {
+                if (mPresetResults[i] < nearby[j])
+                {
+                    ++i;
+                }
+                else if (nearby[j] < mPresetResults[i])
+                {
+                    ++j;
+                }
+                else
+                {
+                    both.add(nearby[j]);
+                    ++i;
+                    ++j;
+                }
+            }
+            mPresetResults.swapWith(both);
+        }
+        mPresetList->deselectAllRows();
+        mPresetList->updateContent();
+        mPresetList->repaint();
+    }
 }
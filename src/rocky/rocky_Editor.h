@@ -14,6 +14,10 @@ namespace rocky
     class RockyEditor
         : public juce::AudioProcessorEditor
         , public juce::Button::Listener
+        , public juce::ComboBox::Listener
+        , public juce::TextEditor::Listener
+        , public juce::ListBoxModel
+        , public juce::ChangeListener
     {
     public:
         explicit RockyEditor(RockyProcessor* inProcessor);
@@ -26,9 +30,32 @@ namespace rocky
     public: // juce::Button::Listener
         virtual void buttonClicked(juce::Button* inButton);
 
+    public: // juce::ComboBox::Listener
+        virtual void comboBoxChanged(juce::ComboBox* inComboBox);
+
+    public: // juce::TextEditor::Listener
+        virtual void textEditorTextChanged(juce::TextEditor& inTextEditor);
+
+    public: // juce::ListBoxModel
+        virtual int getNumRows();
+        virtual void paintListBoxItem(int inRow, juce::Graphics& inGraphics,
+                                      int inWidth, int inHeight, bool inIsSelected);
+        virtual void listBoxItemClicked(int inRow, const juce::MouseEvent& inEvent);
+
+    public: // juce::ChangeListener
+        virtual void changeListenerCallback(juce::ChangeBroadcaster* inSource);
+
     private:
+        RockyProcessor* getProcessor() const;
         void configureLabel(juce::Label* inLabel, bool inIsMain) const;
 
+        /*!
+            Lists the indexed presets whose name contains the filter text and, when a parameter
+            is picked, whose value of it is close to the current one.
+            The list box only paints the visible rows of the results.
+        */
+        void updatePresetList();
+
     private:
         gui::JuceHolder::Instance mJuceHolder;
 
@@ -50,6 +77,11 @@ namespace rocky
     private:
         juce::TextButton* const mSavePresetButton;
         juce::TextButton* const mLoadPresetButton;
+        juce::TextButton* const mRescanPresetsButton;
+        juce::TextEditor* const mPresetFilter;
+        juce::ComboBox* const mPresetParameter; //<! Item id - 2 is the parameter, 1 for any
+        juce::ListBox* const mPresetList;
+        juce::Array<int> mPresetResults;        //<! Index entries of the mPresetList rows
 
     private:
         const juce::Image mLogo;
@@ -8,10 +8,11 @@
 namespace rocky
 {
     RockyEngineBase::RockyEngineBase(RockyProcessor& inProcessor)
-        : juce::Thread("Rocky Engine")
+        : plugin::JobQueue::Job(&inProcessor)
         , mProcessor(inProcessor)
     {
-        initializeEngine();
+        mResult.mStatus         = false;
+        mResult.mStatusString   = juce::String::empty;
     }
 
     RockyEngineBase::~RockyEngineBase()
@@ -21,15 +22,7 @@ namespace rocky
 
     // -------------------------------------------------------------------------
 
-    void RockyEngineBase::run()
-    {
-        execute();
-        triggerAsyncUpdate();
-    }
-
-    // -------------------------------------------------------------------------
-
-    void RockyEngineBase::handleAsyncUpdate()
+    void RockyEngineBase::completed()
     {
         if (!mResult.mStatus)
         {
@@ -39,28 +32,11 @@ namespace rocky
 
     // -------------------------------------------------------------------------
 
-    void RockyEngineBase::initializeEngine()
-    {
-        mResult.mStatus         = false;
-        mResult.mStatusString   = juce::String::empty;
-    }
-
-    // -------------------------------------------------------------------------
-
-    void RockyEngineBase::operator()()
-    {
-		 startThread();
-		 run();
-		 stopThread(-1);
-    }
-
-    // -------------------------------------------------------------------------
-
     RockyPresetSaver::RockyPresetSaver(RockyProcessor& inProcessor, const juce::File& inFile)
         : RockyEngineBase(inProcessor)
         , mFile(inFile)
     {
-		initializeEngine();
+        mProcessor.getStateInformation(mState);
     }
 
     RockyPresetSaver::~RockyPresetSaver()
@@ -79,37 +55,25 @@ namespace rocky
             return;
         }
 
-        juce::FileOutputStream stream(mFile);
-        if (stream.failedToOpen())
+        // Written next to the file first, so that a failure leaves the previous preset whole
+        if (!mFile.replaceWithData(mState.getData(), mState.getSize()))
         {
             mResult.mStatus         = false;
-            mResult.mStatusString   = "Can't open Preset File.";
+            mResult.mStatusString   = "Can't save Preset.";
             return;
         }
 
-        // Update state structure in case it has changed since we last asked for it...
-        mProcessor.getStateInformation(mState);
-
-        stream << mState;
-
-        if (!stream.getStatus())
-        {
-            mResult.mStatus         = false;
-            mResult.mStatusString   = "Can't save Preset.";
-        }
-        else
-        {
-            mResult.mStatus         = true;
-            mResult.mStatusString   = juce::String::empty;
-        }
+        mResult.mStatus         = true;
+        mResult.mStatusString   = juce::String::empty;
     }
 
-    // -------------------------------------------------------------------------
-
-    void RockyPresetSaver::initializeEngine()
+    void RockyPresetSaver::completed()
     {
-        mProcessor.getStateInformation(mState);
-        RockyEngineBase::initializeEngine();
+        if (mResult.mStatus)
+        {
+            mProcessor.scanPresets();
+        }
+        RockyEngineBase::completed();
     }
 
     // -------------------------------------------------------------------------
@@ -118,7 +82,7 @@ namespace rocky
         : RockyEngineBase(inProcessor)
         , mFile(inFile)
     {
-		initializeEngine();
+
     }
 
     RockyPresetLoader::~RockyPresetLoader()
@@ -130,26 +94,30 @@ namespace rocky
 
     void RockyPresetLoader::execute()
     {
-        juce::FileInputStream stream(mFile);
-        if (stream.failedToOpen())
+        if (!mFile.existsAsFile())
         {
             mResult.mStatus         = false;
             mResult.mStatusString   = "Can't open Preset File.";
             return;
         }
 
-        juce::MemoryBlock state;
-        stream.readIntoMemoryBlock(state);
-        if (!stream.getStatus())
+        if (!mFile.loadFileAsData(mState))
         {
             mResult.mStatus         = false;
             mResult.mStatusString   = "Can't load Preset.";
             return;
         }
 
-        mProcessor.setStateInformation(state.getData(), state.getSize());
-
         mResult.mStatus         = true;
         mResult.mStatusString   = juce::String::empty;
     }
+
+    void RockyPresetLoader::completed()
+    {
+        if (mResult.mStatus)
+        {
+            mProcessor.setStateInformation(mState.getData(), int(mState.getSize()));
+        }
+        RockyEngineBase::completed();
+    }
 }
@@ -9,26 +9,18 @@
 
 namespace rocky
 {
-    class RockyEngineBase
-        : public juce::Thread
-        , public juce::AsyncUpdater
+    /*!
+        Preset jobs, run on the shared plugin::JobQueue: the file is read or written there,
+        and the processor is only touched from the message thread, on construction and completion.
+    */
+    class RockyEngineBase : public plugin::JobQueue::Job
     {
     public:
         explicit RockyEngineBase(RockyProcessor& inProcessor);
         virtual ~RockyEngineBase();
 
-    public: // juce::Thread
-        virtual void run();
-
-    public: // juce::AsyncUpdater
-        virtual void handleAsyncUpdate();
-
-    protected: // RockyEngineBase
-        virtual void initializeEngine();
-        virtual void execute() = 0;
-
-    public:
-        void operator()();
+    public: // plugin::JobQueue::Job
+        virtual void completed();
 
     protected:
         struct Result
@@ -53,9 +45,9 @@ namespace rocky
         RockyPresetSaver(RockyProcessor& inProcessor, const juce::File& inFile);
         virtual ~RockyPresetSaver();
 
-    protected: // RockyEngineBase
-        virtual void initializeEngine();
+    public: // plugin::JobQueue::Job
         virtual void execute();
+        virtual void completed();
 
     private:
         const juce::File mFile;
@@ -73,8 +65,9 @@ namespace rocky
         RockyPresetLoader(RockyProcessor& inProcessor, const juce::File& inFile);
         virtual ~RockyPresetLoader();
 
-    protected: // RockyEngineBase
+    public: // plugin::JobQueue::Job
         virtual void execute();
+        virtual void completed();
 
     private:
         const juce::File mFile;
@@ -9,81 +9,66 @@
 
 namespace rocky
 {
-    RockyParametersInfo::RockyParametersInfo()
+    static const parameters::LinearParameterTaper gGainTaper(-24.f, +24.f);
+    static const parameters::LogParameterTaper gHPFrequencyTaper(1.f, 25000.f, 1000.f, .5f);
+    static const parameters::LogParameterTaper gFrequencyTaper(10.f, 25000.f, 1000.f, .5f);
+    static const parameters::LinearParameterTaper gQTaper(.1f, 12.f);
+    static const parameters::LinearParameterTaper gShelfQTaper(.35f, 12.f);
+
+    static const parameters::ValueSuffixDisplayDelegate gGainDisplay("dB", 1, true);
+    static const parameters::ValueSuffixDisplayDelegate gFineGainDisplay("dB", 4, true);
+    static const parameters::ValueSuffixDisplayDelegate gFrequencyDisplay("Hz", 2, false);
+    static const parameters::ValueSuffixDisplayDelegate gQDisplay("", 2, false);
+
+    static const parameters::ParameterInfo gParameterInfos[numParameters] =
     {
-        registerInfo(paramInGain, "Input Gain", 0.f,
-                     new parameters::LinearParameterTaper(-24.f, +24.f),
-                     new parameters::ValueSuffixDisplayDelegate("dB", 1, true),
-                     offsetof(RockyPorts, mInputGain), sizeof(dsp::Gain::Port));
-        registerInfo(paramHPFrequency, "High Pass Frequency", 1000.f,
-                     new parameters::LogParameterTaper(1.f, 25000.f, 1000.f, .5f),
-                     new parameters::ValueSuffixDisplayDelegate("Hz", 2, false),
-                     offsetof(RockyPorts, mHP), sizeof(dsp::IIR::Port));
-        registerInfo(paramHPQ, "High Pass Q", 1.f,
-                     new parameters::LinearParameterTaper(.1f, 12.f),
-                     new parameters::ValueSuffixDisplayDelegate("", 2, false),
-                     offsetof(RockyPorts, mHP), sizeof(dsp::IIR::Port));
-        registerInfo(paramLSFrequency, "Low Shelf Frequency", 1000.f,
-                     new parameters::LogParameterTaper(10.f, 25000.f, 1000.f, .5f),
-                     new parameters::ValueSuffixDisplayDelegate("Hz", 2, false),
-                     offsetof(RockyPorts, mLS), sizeof(dsp::IIR::Port));
-        registerInfo(paramLSQ, "Low Shelf Q", 1.f,
-                     new parameters::LinearParameterTaper(.35f, 12.f),
-                     new parameters::ValueSuffixDisplayDelegate("", 2, false),
-                     offsetof(RockyPorts, mLS), sizeof(dsp::IIR::Port));
-        registerInfo(paramLSGain, "Low Shelf Gain", 0.f,
-                     new parameters::LinearParameterTaper(-24.f, +24.f),
-                     new parameters::ValueSuffixDisplayDelegate("dB", 4, true),
-                     offsetof(RockyPorts, mLS), sizeof(dsp::IIR::Port));
-        registerInfo(paramBell1Frequency, "Bell 1 Frequency", 1000.f,
-                     new parameters::LogParameterTaper(10.f, 25000.f, 1000.f, .5f),
-                     new parameters::ValueSuffixDisplayDelegate("Hz", 2, false),
-                     offsetof(RockyPorts, mBell1), sizeof(dsp::IIR::Port));
-        registerInfo(paramBell1Q, "Bell 1 Q", 1.f,
-                     new parameters::LinearParameterTaper(.1f, 12.f),
-                     new parameters::ValueSuffixDisplayDelegate("", 2, false),
-                     offsetof(RockyPorts, mBell1), sizeof(dsp::IIR::Port));
-        registerInfo(paramBell1Gain, "Bell 1 Gain", 0.f,
-                     new parameters::LinearParameterTaper(-24.f, +24.f),
-                     new parameters::ValueSuffixDisplayDelegate("dB", 1, true),
-                     offsetof(RockyPorts, mBell1), sizeof(dsp::IIR::Port));
-        registerInfo(paramBell2Frequency, "Bell 2 Frequency", 1000.f,
-                     new parameters::LogParameterTaper(10.f, 25000.f, 1000.f, .5f),
-                     new parameters::ValueSuffixDisplayDelegate("Hz", 2, false),
-                     offsetof(RockyPorts, mBell2), sizeof(dsp::IIR::Port));
-        registerInfo(paramBell2Q, "Bell 2 Q", 1.f,
-                     new parameters::LinearParameterTaper(.1f, 12.f),
-                     new parameters::ValueSuffixDisplayDelegate("", 2, false),
-                     offsetof(RockyPorts, mBell2), sizeof(dsp::IIR::Port));
-        registerInfo(paramBell2Gain, "Bell 2 Gain", 0.f,
-                     new parameters::LinearParameterTaper(-24.f, +24.f),
-                     new parameters::ValueSuffixDisplayDelegate("dB", 1, true),
-                     offsetof(RockyPorts, mBell2), sizeof(dsp::IIR::Port));
-        registerInfo(paramHSFrequency, "High Shelf Frequency", 1000.f,
-                     new parameters::LogParameterTaper(10.f, 25000.f, 1000.f, .5f),
-                     new parameters::ValueSuffixDisplayDelegate("Hz", 2, false),
-                     offsetof(RockyPorts, mHS), sizeof(dsp::IIR::Port));
-        registerInfo(paramHSQ, "High Shelf Q", 1.f,
-                     new parameters::LinearParameterTaper(.35f, 12.f),
-                     new parameters::ValueSuffixDisplayDelegate("", 2, false),
-                     offsetof(RockyPorts, mHS), sizeof(dsp::IIR::Port));
-        registerInfo(paramHSGain, "High Shelf Gain", 0.f,
-                     new parameters::LinearParameterTaper(-24.f, +24.f),
-                     new parameters::ValueSuffixDisplayDelegate("dB", 1, true),
-                     offsetof(RockyPorts, mHS), sizeof(dsp::IIR::Port));
-        registerInfo(paramLPFrequency, "Low Pass Frequency", 1000.f,
-                     new parameters::LogParameterTaper(10.f, 25000.f, 1000.f, .5f),
-                     new parameters::ValueSuffixDisplayDelegate("Hz", 2, false),
-                     offsetof(RockyPorts, mLP), sizeof(dsp::IIR::Port));
-        registerInfo(paramLPQ, "Low Pass Q", 1.f,
-                     new parameters::LinearParameterTaper(.1f, 12.f),
-                     new parameters::ValueSuffixDisplayDelegate("", 2, false),
-                     offsetof(RockyPorts, mLP), sizeof(dsp::IIR::Port));
-        registerInfo(paramOutGain, "Output Gain", 0.f,
-                     new parameters::LinearParameterTaper(-24.f, +24.f),
-                     new parameters::ValueSuffixDisplayDelegate("dB", 1, true),
-                     offsetof(RockyPorts, mOutputGain), sizeof(dsp::Gain::Port));
-    }
+        { paramInGain,          "Input Gain",           0.f,    &gGainTaper,        &gGainDisplay,
+          offsetof(RockyPorts, mInputGain),     sizeof(dsp::Gain::Port) },
+        { paramHPFrequency,     "High Pass Frequency",  1000.f, &gHPFrequencyTaper, &gFrequencyDisplay,
+          offsetof(RockyPorts, mHP),            sizeof(dsp::IIR::Port) },
+        { paramHPQ,             "High Pass Q",          1.f,    &gQTaper,           &gQDisplay,
+          offsetof(RockyPorts, mHP),            sizeof(dsp::IIR::Port) },
+        { paramLSFrequency,     "Low Shelf Frequency",  1000.f, &gFrequencyTaper,   &gFrequencyDisplay,
+          offsetof(RockyPorts, mLS),            sizeof(dsp::IIR::Port) },
+        { paramLSQ,             "Low Shelf Q",          1.f,    &gShelfQTaper,      &gQDisplay,
+          offsetof(RockyPorts, mLS),            sizeof(dsp::IIR::Port) },
+        { paramLSGain,          "Low Shelf Gain",       0.f,    &gGainTaper,        &gFineGainDisplay,
+          offsetof(RockyPorts, mLS),            sizeof(dsp::IIR::Port) },
+        { paramBell1Frequency,  "Bell 1 Frequency",     1000.f, &gFrequencyTaper,   &gFrequencyDisplay,
+          offsetof(RockyPorts, mBell1),         sizeof(dsp::IIR::Port) },
+        { paramBell1Q,          "Bell 1 Q",             1.f,    &gQTaper,           &gQDisplay,
+          offsetof(RockyPorts, mBell1),         sizeof(dsp::IIR::Port) },
+        { paramBell1Gain,       "Bell 1 Gain",          0.f,    &gGainTaper,        &gGainDisplay,
+          offsetof(RockyPorts, mBell1),         sizeof(dsp::IIR::Port) },
+        { paramBell2Frequency,  "Bell 2 Frequency",     1000.f, &gFrequencyTaper,   &gFrequencyDisplay,
+          offsetof(RockyPorts, mBell2),         sizeof(dsp::IIR::Port) },
+        { paramBell2Q,          "Bell 2 Q",             1.f,    &gQTaper,           &gQDisplay,
+          offsetof(RockyPorts, mBell2),         sizeof(dsp::IIR::Port) },
+        { paramBell2Gain,       "Bell 2 Gain",          0.f,    &gGainTaper,        &gGainDisplay,
+          offsetof(RockyPorts, mBell2),         sizeof(dsp::IIR::Port) },
+        { paramHSFrequency,     "High Shelf Frequency", 1000.f, &gFrequencyTaper,   &gFrequencyDisplay,
+          offsetof(RockyPorts, mHS),            sizeof(dsp::IIR::Port) },
+        { paramHSQ,             "High Shelf Q",         1.f,    &gShelfQTaper,      &gQDisplay,
+          offsetof(RockyPorts, mHS),            sizeof(dsp::IIR::Port) },
+        { paramHSGain,          "High Shelf Gain",      0.f,    &gGainTaper,        &gGainDisplay,
+          offsetof(RockyPorts, mHS),            sizeof(dsp::IIR::Port) },
+        { paramLPFrequency,     "Low Pass Frequency",   1000.f, &gFrequencyTaper,   &gFrequencyDisplay,
+          offsetof(RockyPorts, mLP),            sizeof(dsp::IIR::Port) },
+        { paramLPQ,             "Low Pass Q",           1.f,    &gQTaper,           &gQDisplay,
+          offsetof(RockyPorts, mLP),            sizeof(dsp::IIR::Port) },
+        { paramOutGain,         "Output Gain",          0.f,    &gGainTaper,        &gGainDisplay,
+          offsetof(RockyPorts, mOutputGain),    sizeof(dsp::Gain::Port) },
+    };
+
+    const parameters::ParametersInfo<numParameters> gParametersInfo(gParameterInfos);
+
+    // -------------------------------------------------------------------------
+
+    RockyPresetIndex::RockyPresetIndex()
+        : plugin::PresetIndex(numParameters,
+                              juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+                                  .getChildFile("Eiosis").getChildFile("Rocky Presets.index"))
+    {}
 
     // -------------------------------------------------------------------------
 
@@ -109,11 +94,19 @@ namespace rocky
         setMapper(paramLPFrequency,     &RockyProcessor::mapLP);
         setMapper(paramLPQ,             &RockyProcessor::mapLP);
         setMapper(paramOutGain,         &RockyProcessor::mapOutputGain);
+
+        // Wide buses split their channel groups across cores, stereo ones stay on the audio thread.
+        // A channel sample costs some 20 ns of cascades, so blocks under 2048 of them (16 channels
+        // of 128 samples) take less time than a parked worker takes to wake up.
+        enableWorkers(juce::SystemStats::getNumCpus() - 1, RockyChain::numLanes, 2048);
+
+        // Offline renders keep the analog shape of bands up to 25 kHz at 44.1 and 48 kHz
+        enableOversampling(88200.);
     }
 
     RockyProcessor::~RockyProcessor()
     {
-
+        mJobs->cancel(this);
     }
 
     // -------------------------------------------------------------------------
@@ -125,16 +118,53 @@ namespace rocky
 
     // -------------------------------------------------------------------------
 
-    void RockyProcessor::savePresetTo(const juce::File& inFile)
+    bool RockyProcessor::savePresetTo(const juce::File& inFile)
+    {
+        return mJobs->post(new RockyPresetSaver(*this, inFile));
+    }
+
+    bool RockyProcessor::loadPresetFrom(const juce::File& inFile)
     {
-		RockyPresetSaver saver(*this, inFile);
-		saver();
+        return mJobs->post(new RockyPresetLoader(*this, inFile));
     }
 
-    void RockyProcessor::loadPresetFrom(const juce::File& inFile)
+    int RockyProcessor::loadProgramsFrom(const juce::Array<juce::File>& inFiles)
     {
-        RockyPresetLoader loader(*this, inFile);
-        loader();
+        juce::StringArray names;
+        juce::Array<juce::MemoryBlock> states;
+        for (int f = 0; f < inFiles.size(); ++f)
+        {
+            juce::MemoryBlock state;
+            if (inFiles[f].loadFileAsData(state))
+            {
+                names.add(inFiles[f].getFileNameWithoutExtension());
+                states.add(state);
+            }
+        }
+        return setPrograms(names, states);
+    }
+
+    plugin::PresetIndex& RockyProcessor::getPresetIndex()
+    {
+        jassert(juce::MessageManager::getInstance()->isThisTheMessageThread());
+        if (mPresetIndex == 0)
+        {
+            mPresetIndex = new juce::SharedResourcePointer<RockyPresetIndex>;
+        }
+        return mPresetIndex->get();
+    }
+
+    void RockyProcessor::scanPresets()
+    {
+        juce::Array<juce::File> directories;
+        directories.add(getPresetsDirectory());
+        getPresetIndex().scan(directories);
+    }
+
+    juce::File RockyProcessor::getPresetsDirectory()
+    {
+        return juce::File::getSpecialLocation(juce::File::userDocumentsDirectory)
+                   .getChildFile("Eiosis").getChildFile("Rocky Presets");
     }
 
     // -------------------------------------------------------------------------
@@ -142,157 +172,160 @@ namespace rocky
     void RockyProcessor::mapInputGain(void* outPortData)
     {
         dsp::Gain::Port& gainPort = *reinterpret_cast<dsp::Gain::Port*>(outPortData);
-        gainPort.mTargetGain = dsp::dBToLinear(getParameterPlain(paramInGain));
+        gainPort.mTargetGain = dsp::dBToLinear(dsp::float64(getParameterPlain(paramInGain)));
     }
 
     void RockyProcessor::mapHP(void* outPortData)
     {
-        const dsp::float32 frequency  = getParameterPlain(paramHPFrequency);
-        const dsp::float32 q          = getParameterPlain(paramHPQ);
+        const dsp::float64 frequency  = getParameterPlain(paramHPFrequency);
+        const dsp::float64 q          = getParameterPlain(paramHPQ);
 
-        const dsp::float32 samplerate = dsp::float32(getSampleRate());
+        const dsp::float64 samplerate = getProcessSamplerate();
 
         jassert(samplerate > 0. && q > 0.);
 
-        const dsp::float32 clippedFreq      = std::min(frequency, .5f * samplerate - 100.f);
-        const dsp::float32 w0               = dsp::twoPi_32 * clippedFreq / samplerate;
-        const dsp::float32 alpha            = std::sin(w0) / (2.f * q);
-        const dsp::float32 ib0              = 1.f / (1.f + alpha);
+        const dsp::float64 clippedFreq      = std::min(frequency, .5 * samplerate - 100.);
+        dsp::float64 sinW0, cosW0;
+        dsp::gSinCosTable.sinCos(clippedFreq / samplerate, sinW0, cosW0);
+        const dsp::float64 alpha            = sinW0 / (2. * q);
+        const dsp::float64 ib0              = 1. / (1. + alpha);
 
         dsp::IIR::Port& iirPort             = *reinterpret_cast<dsp::IIR::Port*>(outPortData);
-        iirPort.mCoefficients[0]            = ib0 * (.5f * (1.f + std::cos(w0)));
-        iirPort.mCoefficients[1]            = ib0 * (-(1.f + std::cos(w0)));
-        iirPort.mCoefficients[2]            = ib0 * (.5f * (1.f + std::cos(w0)));
+        iirPort.mCoefficients[0]            = ib0 * (.5 * (1. + cosW0));
+        iirPort.mCoefficients[1]            = ib0 * (-(1. + cosW0));
+        iirPort.mCoefficients[2]            = ib0 * (.5 * (1. + cosW0));
         iirPort.mCoefficients[3]            = 1.;
-        iirPort.mCoefficients[4]            = ib0 * ( -2.f * std::cos(w0));
-        iirPort.mCoefficients[5]            = ib0 * (1.f - alpha);
+        iirPort.mCoefficients[4]            = ib0 * ( -2. * cosW0);
+        iirPort.mCoefficients[5]            = ib0 * (1. - alpha);
     }
 
     void RockyProcessor::mapLS(void* outPortData)
     {
-        const dsp::float32 frequency  = getParameterPlain(paramLSFrequency);
-        const dsp::float32 q          = getParameterPlain(paramLSQ);
-        const dsp::float32 gain       = getParameterPlain(paramLSGain);
+        const dsp::float64 frequency  = getParameterPlain(paramLSFrequency);
+        const dsp::float64 q          = getParameterPlain(paramLSQ);
+        const dsp::float64 gain       = getParameterPlain(paramLSGain);
 
-        const dsp::float32 samplerate = dsp::float32(getSampleRate());
+        const dsp::float64 samplerate = getProcessSamplerate();
 
         jassert(samplerate > 0. && q > 0.);
 
-        const dsp::float32 clippedFreq      = std::min(frequency, .5f * samplerate - 100.f);
-        const dsp::float32 a                = std::pow(10.f, gain / 40.f);
-        const dsp::float32 aMinus1          = a - 1.f;
-        const dsp::float32 aPlus1           = a + 1.f;
-        const dsp::float32 w                = dsp::twoPi_32 * clippedFreq / samplerate;
-        const dsp::float32 cosW             = std::cos(w);
-        const dsp::float32 beta             = std::sin(w) * std::sqrt(a) / q;
-        const dsp::float32 aMinus1TimesCosW = aMinus1 * cosW;
-        const dsp::float32 ib0              = 1.f / (aPlus1 + aMinus1TimesCosW + beta);
+        const dsp::float64 clippedFreq      = std::min(frequency, .5 * samplerate - 100.);
+        const dsp::float64 a                = dsp::dBToLinear(.5 * gain);
+        const dsp::float64 aMinus1          = a - 1.;
+        const dsp::float64 aPlus1           = a + 1.;
+        dsp::float64 sinW, cosW;
+        dsp::gSinCosTable.sinCos(clippedFreq / samplerate, sinW, cosW);
+        const dsp::float64 beta             = sinW * std::sqrt(a) / q;
+        const dsp::float64 aMinus1TimesCosW = aMinus1 * cosW;
+        const dsp::float64 ib0              = 1. / (aPlus1 + aMinus1TimesCosW + beta);
 
         dsp::IIR::Port& iirPort             = *reinterpret_cast<dsp::IIR::Port*>(outPortData);
         iirPort.mCoefficients[0]            = ib0 * (a * (aPlus1 - aMinus1TimesCosW + beta));
-        iirPort.mCoefficients[1]            = ib0 * (a * 2.f * (aMinus1 - aPlus1 * cosW));
+        iirPort.mCoefficients[1]            = ib0 * (a * 2. * (aMinus1 - aPlus1 * cosW));
         iirPort.mCoefficients[2]            = ib0 * (a * (aPlus1 - aMinus1TimesCosW - beta));
-        iirPort.mCoefficients[3]            = 1.f;
-        iirPort.mCoefficients[4]            = ib0 * (-2.f * (aMinus1 + aPlus1 * cosW));
+        iirPort.mCoefficients[3]            = 1.;
+        iirPort.mCoefficients[4]            = ib0 * (-2. * (aMinus1 + aPlus1 * cosW));
         iirPort.mCoefficients[5]            = ib0 * (aPlus1 + aMinus1TimesCosW - beta);
     }
 
     void RockyProcessor::mapBell1(void* outPortData)
     {
-        const dsp::float32 frequency  = getParameterPlain(paramBell1Frequency);
-        const dsp::float32 q          = getParameterPlain(paramBell2Q);
-        const dsp::float32 gain       = getParameterPlain(paramBell1Gain);
+        const dsp::float64 frequency  = getParameterPlain(paramBell1Frequency);
+        const dsp::float64 q          = getParameterPlain(paramBell2Q);
+        const dsp::float64 gain       = getParameterPlain(paramBell1Gain);
         internalMapBell(outPortData, frequency, q, gain);
     }
 
     void RockyProcessor::mapBell2(void* outPortData)
     {
-        const dsp::float32 frequency  = getParameterPlain(paramBell2Frequency);
-        const dsp::float32 q          = getParameterPlain(paramBell2Q);
-        const dsp::float32 gain       = getParameterPlain(paramBell2Gain);
+        const dsp::float64 frequency  = getParameterPlain(paramBell2Frequency);
+        const dsp::float64 q          = getParameterPlain(paramBell2Q);
+        const dsp::float64 gain       = getParameterPlain(paramBell2Gain);
         internalMapBell(outPortData, frequency, q, gain);
     }
 
-    inline void RockyProcessor::internalMapBell(void* outPortData, float inFrequency,
-                                                float inQ, float inGain)
+    inline void RockyProcessor::internalMapBell(void* outPortData, dsp::float64 inFrequency,
+                                                dsp::float64 inQ, dsp::float64 inGain)
     {
-        const dsp::float32 samplerate = dsp::float32(getSampleRate());
+        const dsp::float64 samplerate = getProcessSamplerate();
 
         jassert(samplerate > 0. && inQ > 0.);
 
-        const dsp::float32 a                = std::pow(10.f, inGain / 40.f);
-        const dsp::float32 w                = (dsp::twoPi_32 * std::min(inFrequency, .5f * samplerate - 100.f)) / samplerate;
-        const dsp::float32 alpha            = .5f * std::sin(w) / inQ;
-        const dsp::float32 c2               = -2.f * std::cos(w);
-        const dsp::float32 alphaTimesA      = alpha * a;
-        const dsp::float32 alpheOverA       = alpha / a;
-        const dsp::float32 ib0              = 1.f / (1.f + alpheOverA);
+        const dsp::float64 a                = dsp::dBToLinear(.5 * inGain);
+        dsp::float64 sinW, cosW;
+        dsp::gSinCosTable.sinCos(std::min(inFrequency, .5 * samplerate - 100.) / samplerate, sinW, cosW);
+        const dsp::float64 alpha            = .5 * sinW / inQ;
+        const dsp::float64 c2               = -2. * cosW;
+        const dsp::float64 alphaTimesA      = alpha * a;
+        const dsp::float64 alpheOverA       = alpha / a;
+        const dsp::float64 ib0              = 1. / (1. + alpheOverA);
 
         dsp::IIR::Port& iirPort             = *reinterpret_cast<dsp::IIR::Port*>(outPortData);
-        iirPort.mCoefficients[0]            = ib0 * (1.f + alphaTimesA);
+        iirPort.mCoefficients[0]            = ib0 * (1. + alphaTimesA);
         iirPort.mCoefficients[1]            = ib0 * c2;
-        iirPort.mCoefficients[2]            = ib0 * (1.f - alphaTimesA);
-        iirPort.mCoefficients[3]            = 1.f;
+        iirPort.mCoefficients[2]            = ib0 * (1. - alphaTimesA);
+        iirPort.mCoefficients[3]            = 1.;
         iirPort.mCoefficients[4]            = ib0 * c2;
-        iirPort.mCoefficients[5]            = ib0 * (1.f - alpheOverA);
+        iirPort.mCoefficients[5]            = ib0 * (1. - alpheOverA);
     }
 
     void RockyProcessor::mapHS(void* outPortData)
     {
-        const dsp::float32 frequency  = getParameterPlain(paramHSFrequency);
-        const dsp::float32 q          = getParameterPlain(paramHSQ);
-        const dsp::float32 gain       = getParameterPlain(paramHSGain);
+        const dsp::float64 frequency  = getParameterPlain(paramHSFrequency);
+        const dsp::float64 q          = getParameterPlain(paramHSQ);
+        const dsp::float64 gain       = getParameterPlain(paramHSGain);
 
-        const dsp::float32 samplerate = dsp::float32(getSampleRate());
+        const dsp::float64 samplerate = getProcessSamplerate();
 
         jassert(samplerate > 0. && q > 0.);
 
-        const dsp::float32 clippedFreq      = frequency;
-        const dsp::float32 a                = std::pow(10.f, gain / 40.f);
-        const dsp::float32 aMinus1          = a - 1.f;
-        const dsp::float32 aPlus1           = a + 1.f;
-        const dsp::float32 w                = dsp::twoPi_32 * clippedFreq / samplerate;
-        const dsp::float32 cosW             = std::cos(w);
-        const dsp::float32 beta             = std::sin(w) * std::sqrt(a) / q;
-        const dsp::float32 aMinus1TimesCosW = aMinus1 * cosW;
-        const dsp::float32 ib0              = 1.f / (aPlus1 - aMinus1TimesCosW + beta);
+        const dsp::float64 clippedFreq      = std::min(frequency, .5 * samplerate - 100.);
+        const dsp::float64 a                = dsp::dBToLinear(.5 * gain);
+        const dsp::float64 aMinus1          = a - 1.;
+        const dsp::float64 aPlus1           = a + 1.;
+        dsp::float64 sinW, cosW;
+        dsp::gSinCosTable.sinCos(clippedFreq / samplerate, sinW, cosW);
+        const dsp::float64 beta             = sinW * std::sqrt(a) / q;
+        const dsp::float64 aMinus1TimesCosW = aMinus1 * cosW;
+        const dsp::float64 ib0              = 1. / (aPlus1 - aMinus1TimesCosW + beta);
 
         dsp::IIR::Port& iirPort             = *reinterpret_cast<dsp::IIR::Port*>(outPortData);
         iirPort.mCoefficients[0]            = ib0 * (a * (aPlus1 + aMinus1TimesCosW + beta));
-        iirPort.mCoefficients[1]            = ib0 * (a * -2.f * (aMinus1 + aPlus1 * cosW));
+        iirPort.mCoefficients[1]            = ib0 * (a * -2. * (aMinus1 + aPlus1 * cosW));
         iirPort.mCoefficients[2]            = ib0 * (a * (aPlus1 + aMinus1TimesCosW - beta));
-        iirPort.mCoefficients[3]            = 1.f;
-        iirPort.mCoefficients[4]            = ib0 * (2.f * (aMinus1 - aPlus1 * cosW));
+        iirPort.mCoefficients[3]            = 1.;
+        iirPort.mCoefficients[4]            = ib0 * (2. * (aMinus1 - aPlus1 * cosW));
         iirPort.mCoefficients[5]            = ib0 * (aPlus1 - aMinus1TimesCosW - beta);
     }
 
     void RockyProcessor::mapLP(void* outPortData)
     {
-        const dsp::float32 frequency  = getParameterPlain(paramLPFrequency);
-        const dsp::float32 q          = getParameterPlain(paramLPQ);
+        const dsp::float64 frequency  = getParameterPlain(paramLPFrequency);
+        const dsp::float64 q          = getParameterPlain(paramLPQ);
 
-        const dsp::float32 samplerate = dsp::float32(getSampleRate());
+        const dsp::float64 samplerate = getProcessSamplerate();
 
         jassert(samplerate > 0. && q > 0.);
 
-        const dsp::float32 clippedFreq      = std::min(frequency, .5f * samplerate - 1e-6f);
-        const dsp::float32 w0               = dsp::twoPi_32 * clippedFreq / samplerate;
-        const dsp::float32 alpha            = std::sin(w0) / (2.f * q);
-        const dsp::float32 ib0              = 1.f / (1.f + alpha);
+        const dsp::float64 clippedFreq      = std::min(frequency, .5 * samplerate - 1e-6);
+        dsp::float64 sinW0, cosW0;
+        dsp::gSinCosTable.sinCos(clippedFreq / samplerate, sinW0, cosW0);
+        const dsp::float64 alpha            = sinW0 / (2. * q);
+        const dsp::float64 ib0              = 1. / (1. + alpha);
 
         dsp::IIR::Port& iirPort             = *reinterpret_cast<dsp::IIR::Port*>(outPortData);
-        iirPort.mCoefficients[0]            = ib0 * (.5f * (1.f - std::cos(w0)));
-        iirPort.mCoefficients[1]            = ib0 * ((1.f - std::cos(w0)));
-        iirPort.mCoefficients[2]            = ib0 * (.5f * (1.f - std::cos(w0)));
-        iirPort.mCoefficients[3]            = 1.f;
-        iirPort.mCoefficients[4]            = ib0 * (-2.f * std::cos(w0));
-        iirPort.mCoefficients[5]            = ib0 * (1.f - alpha);
+        iirPort.mCoefficients[0]            = ib0 * (.5 * (1. - cosW0));
+        iirPort.mCoefficients[1]            = ib0 * ((1. - cosW0));
+        iirPort.mCoefficients[2]            = ib0 * (.5 * (1. - cosW0));
+        iirPort.mCoefficients[3]            = 1.;
+        iirPort.mCoefficients[4]            = ib0 * (-2. * cosW0);
+        iirPort.mCoefficients[5]            = ib0 * (1. - alpha);
     }
 
     void RockyProcessor::mapOutputGain(void* outPortData)
     {
         dsp::Gain::Port& gainPort = *reinterpret_cast<dsp::Gain::Port*>(outPortData);
-        gainPort.mTargetGain = dsp::dBToLinear(getParameterPlain(paramOutGain));
+        gainPort.mTargetGain = dsp::dBToLinear(dsp::float64(getParameterPlain(paramOutGain)));
     }
 }
 
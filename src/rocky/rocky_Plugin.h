@@ -6,6 +6,7 @@
 #pragma once
 
 #include "rocky/rocky_Process.hpp"
+#include "framework/framework_Presets.h"
 
 namespace rocky
 {
@@ -35,13 +36,20 @@ namespace rocky
 
     // -------------------------------------------------------------------------
 
-    struct RockyParametersInfo : parameters::ParametersInfo<numParameters>
+    extern const parameters::ParametersInfo<numParameters> gParametersInfo;
+
+    // -------------------------------------------------------------------------
+
+    /*!
+        The index of the Rocky presets, shared by all the instances of the process.
+    */
+    class RockyPresetIndex
+        : public plugin::PresetIndex
     {
-        RockyParametersInfo();
+    public:
+        RockyPresetIndex();
     };
 
-    static const RockyParametersInfo gParametersInfo;
-
     // -------------------------------------------------------------------------
 
     class RockyProcessor
@@ -55,8 +63,37 @@ namespace rocky
         virtual juce::AudioProcessorEditor* createEditor();
 
     public:
-        void savePresetTo(const juce::File& inFile);
-        void loadPresetFrom(const juce::File& inFile);
+        /*!
+            Save and load the preset on the shared JobQueue, and return right away:
+            errors are reported, and a loaded preset applied, from the message thread when done.
+            Return false when the JobQueue is full.
+        */
+        bool savePresetTo(const juce::File& inFile);
+        bool loadPresetFrom(const juce::File& inFile);
+
+        /*!
+            Loads the given preset files as the program bank, named after the files.
+            Returns the number of programs loaded.
+        */
+        int loadProgramsFrom(const juce::Array<juce::File>& inFiles);
+
+        /*!
+            Rocky presets found by the last scans, for the editor to browse.
+            The shared index is only loaded by the first call, on the message thread,
+            so that processors that never show an editor (such as those of renders) never index.
+        */
+        plugin::PresetIndex& getPresetIndex();
+
+        /*!
+            Rescans the presets directory in the background, as the first editor of the session opens,
+            after each save, and on request from the editor.
+        */
+        void scanPresets();
+
+        /*!
+            Where the preset file choosers open, and the preset index looks for presets.
+        */
+        static juce::File getPresetsDirectory();
 
     private:
         void mapInputGain(void* outPortData);
@@ -69,8 +106,12 @@ namespace rocky
         void mapOutputGain(void* outPortData);
 
     private:
-        inline void internalMapBell(void* outPortData, float inFrequency,
-                                    float inQ, float inGain);
+        inline void internalMapBell(void* outPortData, dsp::float64 inFrequency,
+                                    dsp::float64 inQ, dsp::float64 inGain);
+
+    private:
+        juce::SharedResourcePointer<plugin::JobQueue> mJobs;
+        juce::ScopedPointer<juce::SharedResourcePointer<RockyPresetIndex> > mPresetIndex;   //<! Once used
 
     private:
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RockyProcessor)
@@ -7,6 +7,7 @@
 
 #include "framework/framework_Processor.h"
 #include "framework/framework_Cells.h"
+#include "framework/framework_Oversampling.h"
 
 namespace rocky
 {
@@ -22,61 +23,82 @@ namespace rocky
         dsp::Gain::Port mOutputGain;
     };
 
+    typedef dsp::IIRCascade<6> RockyChain;
+
+    enum { numChannelGroups = plugin::gNumMaxChannels / RockyChain::numLanes };
+
+    /*!
+        Channels are processed by groups of RockyChain::numLanes, each group having its own chain State.
+        Offline renders run the chains oversampled at low samplerates, so that the shelves and bells keep their shape up to Nyquist.
+    */
+    template<typename SampleType>
     struct RockyState : plugin::StateBase
     {
-        dsp::Gain::State mInputGain[plugin::gNumMaxChannels];
-        dsp::IIR::State mHP[plugin::gNumMaxChannels];
-        dsp::IIR::State mLS[plugin::gNumMaxChannels];
-        dsp::IIR::State mBell1[plugin::gNumMaxChannels];
-        dsp::IIR::State mBell2[plugin::gNumMaxChannels];
-        dsp::IIR::State mHS[plugin::gNumMaxChannels];
-        dsp::IIR::State mLP[plugin::gNumMaxChannels];
-        dsp::Gain::State mOutputGain[plugin::gNumMaxChannels];
+        dsp::Oversampler::State<SampleType> mOversampler;
+        RockyChain::State<SampleType> mChains[numChannelGroups];
     };
-}
 
-// -----------------------------------------------------------------------------
+    /*!
+        Runs the chains over the (oversampled) channels, for dsp::Oversampler::process.
+    */
+    template<typename SampleType>
+    struct RockyCells
+    {
+        inline void operator()(const SampleType*const* inInputChannels, SampleType*const* inOutputChannels,
+                               int inNumChannels, int inNumSamples) const
+        {
+            const dsp::IIR::Port* sections[6] =
+            {
+                &mPorts.mHP, &mPorts.mLS, &mPorts.mBell1, &mPorts.mBell2, &mPorts.mHS, &mPorts.mLP,
+            };
 
-template<>
-inline void resetState(rocky::RockyState& ioState)
-{
-    for (unsigned int i = 0; i < plugin::gNumMaxChannels; ++i)
+            plugin::ChannelGroups<RockyChain, SampleType>::process(inInputChannels, inOutputChannels,
+                                                                   inNumChannels, inNumSamples,
+                                                                   mPorts.mInputGain, sections, mPorts.mOutputGain,
+                                                                   mState.mChains, mState.mWorkers);
+        }
+
+        const RockyPorts& mPorts;
+        RockyState<SampleType>& mState;
+    };
+
+    // -------------------------------------------------------------------------
+
+    template<typename SampleType>
+    inline void resetState(RockyState<SampleType>& ioState)
     {
-        dsp::Gain::reset(ioState.mInputGain[i]);
-        dsp::IIR::reset(ioState.mHP[i]);
-        dsp::IIR::reset(ioState.mLS[i]);
-        dsp::IIR::reset(ioState.mBell1[i]);
-        dsp::IIR::reset(ioState.mBell2[i]);
-        dsp::IIR::reset(ioState.mHS[i]);
-        dsp::IIR::reset(ioState.mLP[i]);
-        dsp::Gain::reset(ioState.mOutputGain[i]);
+        static_jassert(plugin::gNumMaxChannels % RockyChain::numLanes == 0);
+
+        dsp::Oversampler::reset(ioState.mOversampler, ioState.mOversampling,
+                                plugin::gNumMaxChannels, ioState.mMaxNumSamples);
+
+        for (int g = 0; g < numChannelGroups; ++g)
+        {
+            RockyChain::reset(ioState.mChains[g], ioState.mSamplerate * ioState.mOversampling);
+        }
     }
-}
 
-template<>
-inline void processState(const dsp::ProcessType*const* inInputChannels, int inNumInputChannels,
-                         dsp::ProcessType*const* inOutputChannels, int inNumOutputChannels,
-                         int inNumSamples, const rocky::RockyPorts& inPorts,
-                         rocky::RockyState& ioState)
-{
-    for (int i = 0; i < inNumInputChannels; ++i)
+    template<typename SampleType>
+    inline void processState(const SampleType*const* inInputChannels, int inNumInputChannels,
+                             SampleType*const* inOutputChannels, int inNumOutputChannels,
+                             int inNumSamples, const RockyPorts& inPorts,
+                             RockyState<SampleType>& ioState)
     {
-        dsp::Gain::process(inInputChannels[i], inOutputChannels[i], inNumSamples,
-                           inPorts.mInputGain, ioState.mInputGain[i]);
-        dsp::IIR::process(inOutputChannels[i], inOutputChannels[i], inNumSamples,
-                          inPorts.mHP, ioState.mHP[i]);
-        dsp::IIR::process(inOutputChannels[i], inOutputChannels[i], inNumSamples,
-                          inPorts.mLS, ioState.mLS[i]);
-        dsp::IIR::process(inOutputChannels[i], inOutputChannels[i], inNumSamples,
-                          inPorts.mBell1, ioState.mBell1[i]);
-        dsp::IIR::process(inOutputChannels[i], inOutputChannels[i], inNumSamples,
-                          inPorts.mBell2, ioState.mBell2[i]);
-        dsp::IIR::process(inOutputChannels[i], inOutputChannels[i], inNumSamples,
-                          inPorts.mHS, ioState.mHS[i]);
-        dsp::IIR::process(inOutputChannels[i], inOutputChannels[i], inNumSamples,
-                          inPorts.mLP, ioState.mLP[i]);
-        dsp::Gain::process(inOutputChannels[i], inOutputChannels[i], inNumSamples,
-                           inPorts.mOutputGain, ioState.mOutputGain[i]);
+        jassert(inNumInputChannels <= int(plugin::gNumMaxChannels));
+
+        const RockyCells<SampleType> cells = { inPorts, ioState };
+        dsp::Oversampler::process(inInputChannels, inOutputChannels, inNumInputChannels, inNumSamples,
+                                  ioState.mOversampler, cells);
+        (void)inNumOutputChannels;
+    }
+
+    inline double tailLengthSeconds(const RockyPorts& inPorts, double inSamplerate)
+    {
+        const dsp::IIR::Port* sections[6] =
+        {
+            &inPorts.mHP, &inPorts.mLS, &inPorts.mBell1, &inPorts.mBell2, &inPorts.mHS, &inPorts.mLP,
+        };
+
+        return RockyChain::tailLength(sections, inSamplerate);
     }
-    (void)inNumOutputChannels;
 }
@@ -8,17 +8,19 @@
 
 namespace shell
 {
-    ShellParametersInfo::ShellParametersInfo()
+    static const parameters::LinearParameterTaper gGainTaper(-18.f, +18.f);
+
+    static const parameters::ValueSuffixDisplayDelegate gGainDisplay("dB", 1, true);
+
+    static const parameters::ParameterInfo gParameterInfos[numParameters] =
     {
-        registerInfo(paramInGain, "Input Gain", 0.f,
-                     new parameters::LinearParameterTaper(-18.f, +18.f),
-                     new parameters::ValueSuffixDisplayDelegate("dB", 1, true),
-                     offsetof(ShellPorts, mInputGain), sizeof(dsp::Gain::Port));
-        registerInfo(paramOutGain, "Output Gain", 0.f,
-                     new parameters::LinearParameterTaper(-18.f, +18.f),
-                     new parameters::ValueSuffixDisplayDelegate("dB", 1, true),
-                     offsetof(ShellPorts, mOutputGain), sizeof(dsp::Gain::Port));
-    }
+        { paramInGain,  "Input Gain",   0.f,    &gGainTaper,    &gGainDisplay,
+          offsetof(ShellPorts, mInputGain),     sizeof(dsp::Gain::Port) },
+        { paramOutGain, "Output Gain",  0.f,    &gGainTaper,    &gGainDisplay,
+          offsetof(ShellPorts, mOutputGain),    sizeof(dsp::Gain::Port) },
+    };
+
+    const parameters::ParametersInfo<numParameters> gParametersInfo(gParameterInfos);
 
     // -------------------------------------------------------------------------
 
@@ -47,13 +49,13 @@ namespace shell
     void ShellProcessor::mapInputGain(void* outPortData)
     {
         dsp::Gain::Port& gainPort = *reinterpret_cast<dsp::Gain::Port*>(outPortData);
-        gainPort.mTargetGain = dsp::dBToLinear(getParameterPlain(paramInGain));
+        gainPort.mTargetGain = dsp::dBToLinear(dsp::float64(getParameterPlain(paramInGain)));
     }
 
     void ShellProcessor::mapOutputGain(void* outPortData)
     {
         dsp::Gain::Port& gainPort = *reinterpret_cast<dsp::Gain::Port*>(outPortData);
-        gainPort.mTargetGain = dsp::dBToLinear(getParameterPlain(paramOutGain));
+        gainPort.mTargetGain = dsp::dBToLinear(dsp::float64(getParameterPlain(paramOutGain)));
     }
 }
 
@@ -19,12 +19,7 @@ namespace shell
 
     // -------------------------------------------------------------------------
 
-    struct ShellParametersInfo : parameters::ParametersInfo<numParameters>
-    {
-        ShellParametersInfo();
-    };
-
-    static const ShellParametersInfo gParametersInfo;
+    extern const parameters::ParametersInfo<numParameters> gParametersInfo;
 
     // -------------------------------------------------------------------------
 
@@ -16,37 +16,53 @@ namespace shell
         dsp::Gain::Port mOutputGain;
     };
 
+    template<typename SampleType>
     struct ShellState : plugin::StateBase
     {
-        dsp::Gain::State mInputGain[plugin::gNumMaxChannels];
-        dsp::Gain::State mOutputGain[plugin::gNumMaxChannels];
+        dsp::Gain::State<SampleType> mInputGain[plugin::gNumMaxChannels];
+        dsp::Gain::State<SampleType> mOutputGain[plugin::gNumMaxChannels];
     };
-}
 
-// -----------------------------------------------------------------------------
+    // -------------------------------------------------------------------------
 
-template<>
-inline void resetState(shell::ShellState& ioState)
-{
-    for (unsigned int i = 0; i < plugin::gNumMaxChannels; ++i)
+    template<typename SampleType>
+    inline void resetState(ShellState<SampleType>& ioState)
     {
-        dsp::Gain::reset(ioState.mInputGain[i]);
-        dsp::Gain::reset(ioState.mOutputGain[i]);
+        for (unsigned int i = 0; i < plugin::gNumMaxChannels; ++i)
+        {
+            dsp::Gain::reset(ioState.mInputGain[i], ioState.mSamplerate);
+            dsp::Gain::reset(ioState.mOutputGain[i], ioState.mSamplerate);
+        }
     }
-}
 
-template<>
-inline void processState(const dsp::ProcessType*const* inInputChannels, int inNumInputChannels,
-                         dsp::ProcessType*const* inOutputChannels, int inNumOutputChannels,
-                         int inNumSamples, const shell::ShellPorts& inPorts,
-                         shell::ShellState& ioState)
-{
-    for (int i = 0; i < inNumInputChannels; ++i)
+    template<typename SampleType>
+    inline void processState(const SampleType*const* inInputChannels, int inNumInputChannels,
+                             SampleType*const* inOutputChannels, int inNumOutputChannels,
+                             int inNumSamples, const ShellPorts& inPorts,
+                             ShellState<SampleType>& ioState)
+    {
+        for (int i = 0; i < inNumInputChannels; ++i)
+        {
+            if (dsp::Silence::isSilent(inInputChannels[i], inNumSamples))
+            {
+                dsp::Gain::skip(inNumSamples, inPorts.mInputGain, ioState.mInputGain[i]);
+                dsp::Gain::skip(inNumSamples, inPorts.mOutputGain, ioState.mOutputGain[i]);
+                dsp::Silence::clear(inOutputChannels[i], inNumSamples);
+                continue;
+            }
+
+            dsp::Gain::process(inInputChannels[i], inOutputChannels[i], inNumSamples,
+                               inPorts.mInputGain, ioState.mInputGain[i]);
+            dsp::Gain::process(inOutputChannels[i], inOutputChannels[i], inNumSamples,
+                               inPorts.mOutputGain, ioState.mOutputGain[i]);
+        }
+        (void)inNumOutputChannels;
+    }
+
+    inline double tailLengthSeconds(const ShellPorts& inPorts, double inSamplerate)
     {
-        dsp::Gain::process(inInputChannels[i], inOutputChannels[i], inNumSamples,
-                           inPorts.mInputGain, ioState.mInputGain[i]);
-        dsp::Gain::process(inOutputChannels[i], inOutputChannels[i], inNumSamples,
-                           inPorts.mOutputGain, ioState.mOutputGain[i]);
+        (void)inPorts;
+        (void)inSamplerate;
+        return 0.;
     }
-    (void)inNumOutputChannels;
 }